@@ -0,0 +1,1077 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+//
+// bitbase.c
+// generation and probing of win/draw/loss tables
+//
+// Tables are generated by retrograde analysis: a first pass values
+// every position by its moves into already finished tables (captures
+// and promotions) and counts the moves staying inside the table.
+// Every following pass takes back the moves into the positions
+// resolved by the pass before: predecessors of a lost position are won,
+// predecessors of a won position lose one move and are lost when no
+// move is left. Everything unresolved at the end is a draw.
+// The index range of every pass is split among threads. Predecessors
+// can be anywhere in the table, so they are updated with atomics.
+//
+// The moves follow the rules of core_functions.c, but are generated on
+// a list of at most BITBASE_MAX_PIECES pieces instead of a full
+// Game_state, since a table has millions of positions.
+//
+
+#define PRIVATE static
+
+#include "bitbase.h"
+#include "core_functions.h"
+#include "mem_utilities.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BITBASE_VERSION 1
+#define BITBASE_HEADER_SIZE 16
+// all pieces, 'v' and '\0'
+#define MATERIAL_LENGTH (BITBASE_MAX_PIECES + 2)
+#define MAX_TABLES 64
+#define MAX_SUCCESSORS 128
+#define MAX_THREADS 64
+
+// the first four are stored in files, V_UNKNOWN only exists while generating
+enum {
+    V_DRAW = BITBASE_DRAW,
+    V_WIN = BITBASE_WIN,
+    V_LOSS = BITBASE_LOSS,
+    V_ILLEGAL,
+    V_UNKNOWN,
+};
+
+/////////////////////////////////////////////////////////////////////
+// Position: A position as a list of pieces. squares[i] is the
+//           square (8 * row + column) of pieces[i].
+/////////////////////////////////////////////////////////////////////
+typedef struct position {
+    int pieces_number;
+    Piece_i pieces[BITBASE_MAX_PIECES];
+    int squares[BITBASE_MAX_PIECES];
+    Color_i to_move;
+} Position;
+
+/////////////////////////////////////////////////////////////////////
+// Table: pieces are in the order of material, which is also the
+//        order of the squares in the index.
+//        signature is the position_signature() of the pieces.
+//        While generating, values holds one byte per position,
+//        moves the number of moves of a position not yet known to
+//        lead into a win of the opponent and frontier marks the
+//        positions resolved in the previous pass.
+/////////////////////////////////////////////////////////////////////
+typedef struct table {
+    char material[MATERIAL_LENGTH];
+    int pieces_number;
+    Piece_i pieces[BITBASE_MAX_PIECES];
+    uint64_t signature;
+    uint32_t size;
+    _Atomic uint8_t *values;
+    _Atomic uint8_t *moves;
+    _Atomic uint8_t *frontier;
+    _Atomic uint8_t *next_frontier;
+} Table;
+
+typedef struct generator {
+    Table tables[MAX_TABLES];
+    int tables_number;
+    int threads;
+} Generator;
+
+typedef struct pass {
+    Generator *generator;
+    Table *table;
+    uint32_t begin;
+    uint32_t end;
+    bool init;
+    long resolved;
+} Pass;
+
+struct bitbase
+{
+    const uint8_t *data;
+    size_t size;
+    Table table;
+};
+
+PRIVATE const int knight_steps[8][2] = {{1,2}, {2,1}, {2,-1}, {1,-2}, {-1,-2}, {-2,-1}, {-2,1}, {-1,2}};
+// even indexes are the directions of rooks, odd ones those of bishops
+PRIVATE const int king_steps[8][2] = {{1,0}, {1,1}, {0,1}, {-1,1}, {-1,0}, {-1,-1}, {0,-1}, {1,-1}};
+
+PRIVATE Kind_i letter_to_kind(char letter);
+PRIVATE char kind_to_letter(Kind_i kind);
+PRIVATE int kind_value(Kind_i kind);
+PRIVATE Color_i opponent(Color_i color);
+PRIVATE bool parse_material(const char *material, Position *position);
+PRIVATE bool material_of(const Position *position, char *material, bool *mirrored);
+PRIVATE uint64_t position_signature(const Position *position, bool mirrored);
+PRIVATE bool table_init(Table *table, const char *material);
+PRIVATE bool position_index(const Table *table, const Position *position, uint32_t *index);
+PRIVATE void position_from_index(const Table *table, uint32_t index, Position *position);
+PRIVATE void fill_board(const Position *position, int board[BOARD_ROWS * BOARD_COLUMNS]);
+PRIVATE bool path_clear(const int *board, int from, int to);
+PRIVATE bool square_attacked(const Position *position, const int *board, int square, Color_i by);
+PRIVATE bool in_check(const Position *position, const int *board, Color_i player);
+PRIVATE void add_successor(const Position *position, const int *board, int piece, int to, Kind_i promotion,
+                           Position *successors, int *successors_number);
+PRIVATE int generate_successors(const Position *position, Position *successors);
+PRIVATE bool position_legal(const Position *position);
+PRIVATE Table *generator_find(Generator *generator, const char *material);
+PRIVATE Table *generate_table(Generator *generator, const char *material);
+PRIVATE int successor_value(Generator *generator, const Table *table, const Position *successor);
+PRIVATE bool init_position(Generator *generator, Table *table, uint32_t index);
+PRIVATE int generate_predecessors(const Position *position, Position *predecessors);
+PRIVATE long retract_position(Table *table, uint32_t index);
+PRIVATE void *run_pass(void *argument);
+PRIVATE long run_passes(Generator *generator, Table *table, bool init);
+PRIVATE bool write_table(const Table *table, const char *path);
+
+/////////////////////////////////////////////////////////////////////
+// bitbase_generate(): The generator and all tables it needed are
+//                     freed before returning.
+/////////////////////////////////////////////////////////////////////
+bool bitbase_generate(const char *material, const char *path, int threads)
+{
+    Generator *generator = mem_alloc(MEM_BITBASE, sizeof(*generator));
+    generator->tables_number = 0;
+    generator->threads = (1 > threads) ? 1 : (MAX_THREADS < threads) ? MAX_THREADS : threads;
+
+    Table *table = generate_table(generator, material);
+    bool written = (NULL != table) && write_table(table, path);
+
+    for (int i = 0; i < generator->tables_number; i++)
+        mem_free(MEM_BITBASE, (void *) generator->tables[i].values, generator->tables[i].size);
+    mem_free(MEM_BITBASE, generator, sizeof(*generator));
+    return written;
+}
+
+/////////////////////////////////////////////////////////////////////
+// bitbase_open(): The header is checked against the size of the
+//                 file, so probing can not read past the mapping.
+/////////////////////////////////////////////////////////////////////
+Bitbase bitbase_open(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (-1 == fd)
+        return NULL;
+
+    struct stat file_stat;
+    if ((-1 == fstat(fd, &file_stat)) || (BITBASE_HEADER_SIZE > file_stat.st_size))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    const uint8_t *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == data)
+        return NULL;
+
+    Bitbase bitbase = mem_alloc(MEM_BITBASE, sizeof(*bitbase));
+    bitbase->data = data;
+    bitbase->size = file_stat.st_size;
+
+    char material[BITBASE_HEADER_SIZE - 5];
+    memcpy(material, data + 6, sizeof(material) - 1);
+    material[sizeof(material) - 1] = '\0';
+    if ((0 != memcmp(data, "CHBB", 4)) || (BITBASE_VERSION != data[4])
+     || !table_init(&bitbase->table, material)
+     || (0 != strcmp(material, bitbase->table.material))
+     || (data[5] != bitbase->table.pieces_number)
+     || ((size_t) file_stat.st_size != BITBASE_HEADER_SIZE + (bitbase->table.size + 3) / 4))
+    {
+        bitbase_close(bitbase);
+        return NULL;
+    }
+    return bitbase;
+}
+
+/////////////////////////////////////////////////////////////////////
+// bitbase_close(): Unmaps the table and frees it.
+/////////////////////////////////////////////////////////////////////
+void bitbase_close(Bitbase bitbase)
+{
+    munmap((void *) bitbase->data, bitbase->size);
+    mem_free(MEM_BITBASE, bitbase, sizeof(*bitbase));
+}
+
+/////////////////////////////////////////////////////////////////////
+// bitbase_material(): Returns the name of the table.
+/////////////////////////////////////////////////////////////////////
+const char *bitbase_material(const Bitbase bitbase)
+{
+    return bitbase->table.material;
+}
+
+/////////////////////////////////////////////////////////////////////
+// bitbase_probe(): Collects the pieces of state and reads their
+//                  value. move_number counts half-moves starting
+//                  with 1 for white.
+/////////////////////////////////////////////////////////////////////
+Bitbase_value bitbase_probe(const Bitbase bitbase, const Game_state *state)
+{
+    Position position = { .pieces_number = 0, .to_move = (1 == state->move_number % 2) ? WHITE_i : BLACK_i };
+    for (int i = 0; i < BOARD_ROWS; i++)
+    {
+        for (int j = 0; j < BOARD_COLUMNS; j++)
+        {
+            if (EMPTY == state->board[i][j].kind)
+                continue;
+            if (BITBASE_MAX_PIECES == position.pieces_number)
+                return BITBASE_UNKNOWN;
+            position.pieces[position.pieces_number] = state->board[i][j];
+            position.squares[position.pieces_number++] = i * BOARD_COLUMNS + j;
+        }
+    }
+
+    uint32_t index;
+    if (!position_index(&bitbase->table, &position, &index))
+        return BITBASE_UNKNOWN;
+
+    int value = (bitbase->data[BITBASE_HEADER_SIZE + index / 4] >> (2 * (index % 4))) & 3;
+    return (V_ILLEGAL == value) ? BITBASE_UNKNOWN : (Bitbase_value) value;
+}
+
+/////////////////////////////////////////////////////////////////////
+// letter_to_kind(): Returns EMPTY for letters which are no piece.
+/////////////////////////////////////////////////////////////////////
+PRIVATE Kind_i letter_to_kind(char letter)
+{
+    switch (letter)
+    {
+        case 'K':   return KING;
+        case 'Q':   return QUEEN;
+        case 'R':   return ROOK;
+        case 'B':   return BISHOP;
+        case 'N':   return KNIGHT;
+        case 'P':   return PAWN;
+        default:    return EMPTY;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////
+// kind_to_letter(): Inverse of letter_to_kind().
+/////////////////////////////////////////////////////////////////////
+PRIVATE char kind_to_letter(Kind_i kind)
+{
+    return " PNBRQK"[kind];
+}
+
+/////////////////////////////////////////////////////////////////////
+// kind_value(): Decides which side of an ending is stored as white.
+/////////////////////////////////////////////////////////////////////
+PRIVATE int kind_value(Kind_i kind)
+{
+    static const int values[] = {0, 1, 3, 3, 5, 9, 0};
+    return values[kind];
+}
+
+/////////////////////////////////////////////////////////////////////
+// opponent(): Returns the other color.
+/////////////////////////////////////////////////////////////////////
+PRIVATE Color_i opponent(Color_i color)
+{
+    return (WHITE_i == color) ? BLACK_i : WHITE_i;
+}
+
+/////////////////////////////////////////////////////////////////////
+// parse_material(): Reads a name like "KRvKP" into the pieces of
+//                   position. The squares are left undefined.
+//                   Both sides need exactly one king, which has to
+//                   be the first letter of the side.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool parse_material(const char *material, Position *position)
+{
+    Color_i color = WHITE_i;
+    const char *p = material;
+    position->pieces_number = 0;
+    position->to_move = WHITE_i;
+
+    for (;;)
+    {
+        if ('K' != *p++)
+            return false;
+        if (BITBASE_MAX_PIECES == position->pieces_number)
+            return false;
+        position->pieces[position->pieces_number++] = (Piece_i) {color, KING};
+
+        for (; ('\0' != *p) && ('v' != *p); p++)
+        {
+            Kind_i kind = letter_to_kind(*p);
+            if ((EMPTY == kind) || (KING == kind) || (BITBASE_MAX_PIECES == position->pieces_number))
+                return false;
+            position->pieces[position->pieces_number++] = (Piece_i) {color, kind};
+        }
+
+        if (BLACK_i == color)
+            return '\0' == *p;
+        if ('v' != *p++)
+            return false;
+        color = BLACK_i;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////
+// material_of(): Writes the name of the table position belongs to
+//                into material. Each side is written king first,
+//                then from queens down to pawns. The side with more
+//                material (by value, then number of pieces, then
+//                name) is written first. *mirrored tells if this
+//                is black.
+//                Returns false if a side does not have exactly one
+//                king.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool material_of(const Position *position, char *material, bool *mirrored)
+{
+    char sides[2][MATERIAL_LENGTH];
+    int lengths[2] = {0, 0};
+    int values[2] = {0, 0};
+    int kings[2] = {0, 0};
+
+    for (Kind_i kind = KING; kind >= PAWN; kind--)
+    {
+        for (int i = 0; i < position->pieces_number; i++)
+        {
+            if (kind != position->pieces[i].kind)
+                continue;
+            int side = (WHITE_i == position->pieces[i].color) ? 0 : 1;
+            sides[side][lengths[side]++] = kind_to_letter(kind);
+            values[side] += kind_value(kind);
+            kings[side] += (KING == kind);
+        }
+    }
+    if ((1 != kings[0]) || (1 != kings[1]))
+        return false;
+    sides[0][lengths[0]] = '\0';
+    sides[1][lengths[1]] = '\0';
+
+    *mirrored = (values[1] > values[0])
+             || ((values[1] == values[0]) && (lengths[1] > lengths[0]))
+             || ((values[1] == values[0]) && (lengths[1] == lengths[0]) && (0 < strcmp(sides[1], sides[0])));
+    sprintf(material, "%sv%s", sides[*mirrored], sides[!*mirrored]);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+// position_signature(): Counts the pieces of each color and kind in
+//                       four bits each. Two positions belong to the
+//                       same table if their signatures are equal,
+//                       which is much cheaper to test than comparing
+//                       names.
+//                       mirrored swaps the colors.
+/////////////////////////////////////////////////////////////////////
+PRIVATE uint64_t position_signature(const Position *position, bool mirrored)
+{
+    uint64_t signature = 0;
+    for (int i = 0; i < position->pieces_number; i++)
+    {
+        bool black = (BLACK_i == position->pieces[i].color) != mirrored;
+        signature += 1ULL << (4 * (6 * black + position->pieces[i].kind - PAWN));
+    }
+    return signature;
+}
+
+/////////////////////////////////////////////////////////////////////
+// table_init(): Sets up table for material, which does not need to
+//               be in the canonical order of material_of().
+//               No memory for values is allocated.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool table_init(Table *table, const char *material)
+{
+    Position position;
+    bool mirrored;
+    if ((BITBASE_MAX_PIECES + 1 < strlen(material))
+     || !parse_material(material, &position)
+     || !material_of(&position, table->material, &mirrored))
+        return false;
+
+    parse_material(table->material, &position);
+    table->pieces_number = position.pieces_number;
+    memcpy(table->pieces, position.pieces, sizeof(table->pieces));
+    table->signature = position_signature(&position, false);
+    table->size = 2;
+    for (int i = 0; i < table->pieces_number; i++)
+        table->size *= BOARD_ROWS * BOARD_COLUMNS;
+    table->values = NULL;
+    table->moves = NULL;
+    table->frontier = NULL;
+    table->next_frontier = NULL;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+// position_index(): Computes the index of position in table,
+//                   mirroring it if necessary.
+//                   Returns false if the material does not match.
+//                   Identical pieces can be given in any order, all
+//                   orders are positions of the table. Pieces are
+//                   assigned to the slots of the table in the order
+//                   of position, so for a position coming from
+//                   position_from_index() piece i stays in slot i
+//                   after a move.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool position_index(const Table *table, const Position *position, uint32_t *index)
+{
+    bool mirrored;
+    if (table->signature == position_signature(position, false))
+        mirrored = false;
+    else if (table->signature == position_signature(position, true))
+        mirrored = true;
+    else
+        return false;
+
+    bool used[BITBASE_MAX_PIECES] = {false};
+    uint32_t squares = 0;
+    uint32_t factor = 1;
+    for (int slot = 0; slot < table->pieces_number; slot++)
+    {
+        for (int i = 0; i < position->pieces_number; i++)
+        {
+            Color_i color = mirrored ? opponent(position->pieces[i].color) : position->pieces[i].color;
+            if (used[i] || (color != table->pieces[slot].color) || (position->pieces[i].kind != table->pieces[slot].kind))
+                continue;
+            used[i] = true;
+            // mirroring flips the rows
+            squares += factor * (mirrored ? position->squares[i] ^ 56 : position->squares[i]);
+            factor *= 64;
+            break;
+        }
+    }
+
+    Color_i to_move = mirrored ? opponent(position->to_move) : position->to_move;
+    *index = 2 * squares + (BLACK_i == to_move);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+// position_from_index(): Inverse of position_index(), without
+//                        mirroring.
+/////////////////////////////////////////////////////////////////////
+PRIVATE void position_from_index(const Table *table, uint32_t index, Position *position)
+{
+    position->pieces_number = table->pieces_number;
+    position->to_move = (index & 1) ? BLACK_i : WHITE_i;
+    index >>= 1;
+    for (int i = 0; i < table->pieces_number; i++)
+    {
+        position->pieces[i] = table->pieces[i];
+        position->squares[i] = index % 64;
+        index /= 64;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////
+// fill_board(): Writes the index of the piece on each square into
+//               board, -1 for empty squares.
+/////////////////////////////////////////////////////////////////////
+PRIVATE void fill_board(const Position *position, int board[BOARD_ROWS * BOARD_COLUMNS])
+{
+    for (int i = 0; i < BOARD_ROWS * BOARD_COLUMNS; i++)
+        board[i] = -1;
+    for (int i = 0; i < position->pieces_number; i++)
+        board[position->squares[i]] = i;
+}
+
+/////////////////////////////////////////////////////////////////////
+// path_clear(): Checks if all squares between from and to are
+//               empty. from and to have to be on a line.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool path_clear(const int *board, int from, int to)
+{
+    int row_step = (to / 8 > from / 8) - (to / 8 < from / 8);
+    int column_step = (to % 8 > from % 8) - (to % 8 < from % 8);
+    int step = 8 * row_step + column_step;
+    for (int square = from + step; square != to; square += step)
+    {
+        if (-1 != board[square])
+            return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+// square_attacked(): Checks if a piece of color by attacks square.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool square_attacked(const Position *position, const int *board, int square, Color_i by)
+{
+    for (int i = 0; i < position->pieces_number; i++)
+    {
+        if (by != position->pieces[i].color)
+            continue;
+        int rows = square / 8 - position->squares[i] / 8;
+        int columns = square % 8 - position->squares[i] % 8;
+        int rows_abs = abs(rows);
+        int columns_abs = abs(columns);
+        bool straight = ((0 == rows) != (0 == columns));
+        bool diagonal = ((0 != rows) && (rows_abs == columns_abs));
+
+        switch (position->pieces[i].kind)
+        {
+            case PAWN:      if ((rows == ((WHITE_i == by) ? 1 : -1)) && (1 == columns_abs))
+                                return true;
+                            break;
+            case KNIGHT:    if (2 == rows_abs * columns_abs)
+                                return true;
+                            break;
+            case KING:      if ((1 >= rows_abs) && (1 >= columns_abs) && (0 != rows_abs + columns_abs))
+                                return true;
+                            break;
+            case BISHOP:    if (diagonal && path_clear(board, position->squares[i], square))
+                                return true;
+                            break;
+            case ROOK:      if (straight && path_clear(board, position->squares[i], square))
+                                return true;
+                            break;
+            case QUEEN:     if ((straight || diagonal) && path_clear(board, position->squares[i], square))
+                                return true;
+                            break;
+            default:        break;
+        }
+    }
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////
+// in_check(): Checks if the king of player is attacked.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool in_check(const Position *position, const int *board, Color_i player)
+{
+    for (int i = 0; i < position->pieces_number; i++)
+    {
+        if ((KING == position->pieces[i].kind) && (player == position->pieces[i].color))
+            return square_attacked(position, board, position->squares[i], opponent(player));
+    }
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////
+// add_successor(): Moves piece to the square to (promoting it if
+//                  promotion is not EMPTY) and appends the result to
+//                  successors, unless the move is illegal.
+/////////////////////////////////////////////////////////////////////
+PRIVATE void add_successor(const Position *position, const int *board, int piece, int to, Kind_i promotion,
+                           Position *successors, int *successors_number)
+{
+    Color_i player = position->pieces[piece].color;
+    int captured = board[to];
+    if ((-1 != captured)
+     && ((player == position->pieces[captured].color) || (KING == position->pieces[captured].kind)))
+        return;
+
+    Position successor = *position;
+    successor.squares[piece] = to;
+    if (EMPTY != promotion)
+        successor.pieces[piece].kind = promotion;
+    if (-1 != captured)
+    {
+        int last = --successor.pieces_number;
+        successor.pieces[captured] = successor.pieces[last];
+        successor.squares[captured] = successor.squares[last];
+    }
+    successor.to_move = opponent(player);
+
+    // in_check() only needs to know which squares are occupied
+    int successor_board[BOARD_ROWS * BOARD_COLUMNS];
+    memcpy(successor_board, board, sizeof(successor_board));
+    successor_board[position->squares[piece]] = -1;
+    successor_board[to] = piece;
+    if (!in_check(&successor, successor_board, player))
+        successors[(*successors_number)++] = successor;
+}
+
+/////////////////////////////////////////////////////////////////////
+// generate_successors(): Writes the positions after all legal moves
+//                        of the player to move into successors.
+//                        Returns their number.
+/////////////////////////////////////////////////////////////////////
+PRIVATE int generate_successors(const Position *position, Position *successors)
+{
+    static const Kind_i promotions[] = {QUEEN, ROOK, BISHOP, KNIGHT};
+    int board[BOARD_ROWS * BOARD_COLUMNS];
+    fill_board(position, board);
+    int successors_number = 0;
+
+    for (int i = 0; i < position->pieces_number; i++)
+    {
+        if (position->to_move != position->pieces[i].color)
+            continue;
+        int row = position->squares[i] / 8;
+        int column = position->squares[i] % 8;
+
+        switch (position->pieces[i].kind)
+        {
+            case KNIGHT:
+            case KING:
+            {
+                const int (*steps)[2] = (KNIGHT == position->pieces[i].kind) ? knight_steps : king_steps;
+                for (int k = 0; k < 8; k++)
+                {
+                    int to_row = row + steps[k][0];
+                    int to_column = column + steps[k][1];
+                    if ((0 <= to_row) && (BOARD_ROWS > to_row) && (0 <= to_column) && (BOARD_COLUMNS > to_column))
+                        add_successor(position, board, i, 8 * to_row + to_column, EMPTY, successors, &successors_number);
+                }
+                break;
+            }
+            case BISHOP:
+            case ROOK:
+            case QUEEN:
+                for (int k = 0; k < 8; k++)
+                {
+                    if (((ROOK == position->pieces[i].kind) && (k % 2))
+                     || ((BISHOP == position->pieces[i].kind) && !(k % 2)))
+                        continue;
+                    int to_row = row + king_steps[k][0];
+                    int to_column = column + king_steps[k][1];
+                    for (; (0 <= to_row) && (BOARD_ROWS > to_row) && (0 <= to_column) && (BOARD_COLUMNS > to_column);
+                           to_row += king_steps[k][0], to_column += king_steps[k][1])
+                    {
+                        add_successor(position, board, i, 8 * to_row + to_column, EMPTY, successors, &successors_number);
+                        if (-1 != board[8 * to_row + to_column])
+                            break;
+                    }
+                }
+                break;
+            case PAWN:
+            {
+                int direction = (WHITE_i == position->pieces[i].color) ? 1 : -1;
+                int start_row = (WHITE_i == position->pieces[i].color) ? 1 : BOARD_ROWS - 2;
+                int to_row = row + direction;
+                bool promoting = ((0 == to_row) || (BOARD_ROWS - 1 == to_row));
+                int kinds_number = promoting ? 4 : 1;
+
+                if (-1 == board[8 * to_row + column])
+                {
+                    for (int k = 0; k < kinds_number; k++)
+                        add_successor(position, board, i, 8 * to_row + column, promoting ? promotions[k] : EMPTY,
+                                      successors, &successors_number);
+                    if ((start_row == row) && (-1 == board[8 * (to_row + direction) + column]))
+                        add_successor(position, board, i, 8 * (to_row + direction) + column, EMPTY,
+                                      successors, &successors_number);
+                }
+                for (int to_column = column - 1; to_column <= column + 1; to_column += 2)
+                {
+                    if ((0 > to_column) || (BOARD_COLUMNS <= to_column) || (-1 == board[8 * to_row + to_column]))
+                        continue;
+                    for (int k = 0; k < kinds_number; k++)
+                        add_successor(position, board, i, 8 * to_row + to_column, promoting ? promotions[k] : EMPTY,
+                                      successors, &successors_number);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return successors_number;
+}
+
+/////////////////////////////////////////////////////////////////////
+// position_legal(): Pieces have to be on different squares, pawns
+//                   can not stand on the first or last row and the
+//                   player not to move can not be in check.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool position_legal(const Position *position)
+{
+    int board[BOARD_ROWS * BOARD_COLUMNS];
+    fill_board(position, board);
+    for (int i = 0; i < position->pieces_number; i++)
+    {
+        if (i != board[position->squares[i]])
+            return false;
+        int row = position->squares[i] / 8;
+        if ((PAWN == position->pieces[i].kind) && ((0 == row) || (BOARD_ROWS - 1 == row)))
+            return false;
+    }
+    return !in_check(position, board, opponent(position->to_move));
+}
+
+/////////////////////////////////////////////////////////////////////
+// generator_find(): Returns the already generated table for the
+//                   canonical name material or NULL.
+/////////////////////////////////////////////////////////////////////
+PRIVATE Table *generator_find(Generator *generator, const char *material)
+{
+    for (int i = 0; i < generator->tables_number; i++)
+    {
+        if (0 == strcmp(material, generator->tables[i].material))
+            return &generator->tables[i];
+    }
+    return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////
+// generate_table(): First generates the tables of all endings a
+//                   capture or promotion can lead to, then the table
+//                   for material itself.
+//                   Returns NULL if material is invalid.
+/////////////////////////////////////////////////////////////////////
+PRIVATE Table *generate_table(Generator *generator, const char *material)
+{
+    static const Kind_i promotions[] = {QUEEN, ROOK, BISHOP, KNIGHT};
+    Table table;
+    if (!table_init(&table, material))
+        return NULL;
+    Table *found = generator_find(generator, table.material);
+    if (NULL != found)
+        return found;
+
+    Position pieces = { .pieces_number = table.pieces_number };
+    memcpy(pieces.pieces, table.pieces, sizeof(pieces.pieces));
+    char child[MATERIAL_LENGTH];
+    bool mirrored;
+    for (int i = 0; i < table.pieces_number; i++)
+    {
+        if (KING == table.pieces[i].kind)
+            continue;
+
+        Position captured = pieces;
+        captured.pieces[i] = captured.pieces[--captured.pieces_number];
+        material_of(&captured, child, &mirrored);
+        generate_table(generator, child);
+
+        if (PAWN != table.pieces[i].kind)
+            continue;
+        for (int k = 0; k < 4; k++)
+        {
+            Position promoted = pieces;
+            promoted.pieces[i].kind = promotions[k];
+            material_of(&promoted, child, &mirrored);
+            generate_table(generator, child);
+        }
+    }
+
+    if (MAX_TABLES == generator->tables_number)
+    {
+        fprintf(stderr, "error: %s: too many tables needed for %s\n", __func__, table.material);
+        exit(EXIT_FAILURE);
+    }
+    Table *new_table = &generator->tables[generator->tables_number++];
+    *new_table = table;
+    new_table->values = mem_alloc(MEM_BITBASE, new_table->size);
+    new_table->moves = mem_alloc(MEM_BITBASE, new_table->size);
+    new_table->frontier = mem_calloc(MEM_BITBASE, new_table->size, 1);
+    new_table->next_frontier = mem_calloc(MEM_BITBASE, new_table->size, 1);
+
+    long resolved = run_passes(generator, new_table, true);
+    while (0 < resolved)
+    {
+        _Atomic uint8_t *frontier = new_table->frontier;
+        new_table->frontier = new_table->next_frontier;
+        new_table->next_frontier = frontier;
+        memset((void *) new_table->next_frontier, 0, new_table->size);
+        resolved = run_passes(generator, new_table, false);
+    }
+
+    for (uint32_t i = 0; i < new_table->size; i++)
+    {
+        if (V_UNKNOWN == new_table->values[i])
+            new_table->values[i] = V_DRAW;
+    }
+    mem_free(MEM_BITBASE, (void *) new_table->moves, new_table->size);
+    mem_free(MEM_BITBASE, (void *) new_table->frontier, new_table->size);
+    mem_free(MEM_BITBASE, (void *) new_table->next_frontier, new_table->size);
+    new_table->moves = new_table->frontier = new_table->next_frontier = NULL;
+    return new_table;
+}
+
+/////////////////////////////////////////////////////////////////////
+// successor_value(): Returns the value of successor for the player
+//                    to move in successor, if it belongs to an
+//                    already generated table other than table.
+//                    Returns V_UNKNOWN for positions of table.
+/////////////////////////////////////////////////////////////////////
+PRIVATE int successor_value(Generator *generator, const Table *table, const Position *successor)
+{
+    uint32_t index;
+    if (position_index(table, successor, &index))
+        return V_UNKNOWN;
+
+    for (int i = 0; i < generator->tables_number; i++)
+    {
+        if (position_index(&generator->tables[i], successor, &index))
+            return atomic_load_explicit(&generator->tables[i].values[index], memory_order_relaxed);
+    }
+    fprintf(stderr, "error: %s: table of successor missing; aborting\n", __func__);
+    exit(EXIT_FAILURE);
+}
+
+/////////////////////////////////////////////////////////////////////
+// init_position(): Sets the value of index from the moves leaving
+//                  the table and counts the moves staying inside it.
+//                  Moves into other tables leading to a draw are
+//                  counted too, so the position can never become
+//                  lost.
+//                  Returns true if the value is known already.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool init_position(Generator *generator, Table *table, uint32_t index)
+{
+    Position position;
+    Position successors[MAX_SUCCESSORS];
+    int board[BOARD_ROWS * BOARD_COLUMNS];
+
+    position_from_index(table, index, &position);
+    if (!position_legal(&position))
+    {
+        table->values[index] = V_ILLEGAL;
+        return false;
+    }
+
+    int successors_number = generate_successors(&position, successors);
+    if (0 == successors_number)
+    {
+        fill_board(&position, board);
+        table->values[index] = in_check(&position, board, position.to_move) ? V_LOSS : V_DRAW;
+        return V_LOSS == table->values[index];
+    }
+
+    int moves = 0;
+    for (int i = 0; i < successors_number; i++)
+    {
+        int value = successor_value(generator, table, &successors[i]);
+        if (V_LOSS == value)
+        {
+            table->values[index] = V_WIN;
+            return true;
+        }
+        if (V_WIN != value)
+            moves++;
+    }
+    table->values[index] = (0 == moves) ? V_LOSS : V_UNKNOWN;
+    table->moves[index] = moves;
+    return 0 == moves;
+}
+
+/////////////////////////////////////////////////////////////////////
+// generate_predecessors(): Writes all legal positions of the same
+//                          table, from which the player not to move
+//                          could have reached position, into
+//                          predecessors. Captures and promotions
+//                          lead into other tables and are never
+//                          taken back.
+//                          Returns their number.
+/////////////////////////////////////////////////////////////////////
+PRIVATE int generate_predecessors(const Position *position, Position *predecessors)
+{
+    int board[BOARD_ROWS * BOARD_COLUMNS];
+    fill_board(position, board);
+    Color_i player = opponent(position->to_move);
+    int predecessors_number = 0;
+    int from[2 * BOARD_ROWS * BOARD_COLUMNS];
+
+    for (int i = 0; i < position->pieces_number; i++)
+    {
+        if (player != position->pieces[i].color)
+            continue;
+        int row = position->squares[i] / 8;
+        int column = position->squares[i] % 8;
+        int from_number = 0;
+
+        switch (position->pieces[i].kind)
+        {
+            case KNIGHT:
+            case KING:
+            {
+                const int (*steps)[2] = (KNIGHT == position->pieces[i].kind) ? knight_steps : king_steps;
+                for (int k = 0; k < 8; k++)
+                {
+                    int from_row = row + steps[k][0];
+                    int from_column = column + steps[k][1];
+                    if ((0 <= from_row) && (BOARD_ROWS > from_row) && (0 <= from_column) && (BOARD_COLUMNS > from_column)
+                     && (-1 == board[8 * from_row + from_column]))
+                        from[from_number++] = 8 * from_row + from_column;
+                }
+                break;
+            }
+            case BISHOP:
+            case ROOK:
+            case QUEEN:
+                for (int k = 0; k < 8; k++)
+                {
+                    if (((ROOK == position->pieces[i].kind) && (k % 2))
+                     || ((BISHOP == position->pieces[i].kind) && !(k % 2)))
+                        continue;
+                    int from_row = row + king_steps[k][0];
+                    int from_column = column + king_steps[k][1];
+                    for (; (0 <= from_row) && (BOARD_ROWS > from_row) && (0 <= from_column) && (BOARD_COLUMNS > from_column)
+                           && (-1 == board[8 * from_row + from_column]);
+                           from_row += king_steps[k][0], from_column += king_steps[k][1])
+                        from[from_number++] = 8 * from_row + from_column;
+                }
+                break;
+            case PAWN:
+            {
+                int direction = (WHITE_i == player) ? 1 : -1;
+                int start_row = (WHITE_i == player) ? 1 : BOARD_ROWS - 2;
+                int from_row = row - direction;
+                if ((0 < from_row) && (BOARD_ROWS - 1 > from_row) && (-1 == board[8 * from_row + column]))
+                {
+                    from[from_number++] = 8 * from_row + column;
+                    if ((start_row + 2 * direction == row) && (-1 == board[8 * start_row + column]))
+                        from[from_number++] = 8 * start_row + column;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        for (int k = 0; k < from_number; k++)
+        {
+            Position predecessor = *position;
+            predecessor.squares[i] = from[k];
+            predecessor.to_move = player;
+            if (position_legal(&predecessor))
+                predecessors[predecessors_number++] = predecessor;
+        }
+    }
+    return predecessors_number;
+}
+
+/////////////////////////////////////////////////////////////////////
+// retract_position(): index has just been resolved. If it is lost,
+//                     all predecessors are won. If it is won, one
+//                     more move of each predecessor leads into a
+//                     win of the opponent; when that was the last
+//                     one, the predecessor is lost.
+//                     Predecessors can be in the range of other
+//                     threads, so they are only changed atomically.
+//                     Returns the number of positions resolved.
+/////////////////////////////////////////////////////////////////////
+PRIVATE long retract_position(Table *table, uint32_t index)
+{
+    Position position;
+    Position predecessors[MAX_SUCCESSORS];
+    position_from_index(table, index, &position);
+    int value = atomic_load_explicit(&table->values[index], memory_order_relaxed);
+    int predecessors_number = generate_predecessors(&position, predecessors);
+    long resolved = 0;
+
+    for (int i = 0; i < predecessors_number; i++)
+    {
+        uint32_t predecessor;
+        position_index(table, &predecessors[i], &predecessor);
+        if (V_UNKNOWN != atomic_load_explicit(&table->values[predecessor], memory_order_relaxed))
+            continue;
+
+        uint8_t unknown = V_UNKNOWN;
+        if (V_LOSS == value)
+        {
+            if (atomic_compare_exchange_strong_explicit(&table->values[predecessor], &unknown, V_WIN,
+                                                        memory_order_relaxed, memory_order_relaxed))
+            {
+                atomic_store_explicit(&table->next_frontier[predecessor], 1, memory_order_relaxed);
+                resolved++;
+            }
+        }
+        else if (1 == atomic_fetch_sub_explicit(&table->moves[predecessor], 1, memory_order_relaxed))
+        {
+            if (atomic_compare_exchange_strong_explicit(&table->values[predecessor], &unknown, V_LOSS,
+                                                        memory_order_relaxed, memory_order_relaxed))
+            {
+                atomic_store_explicit(&table->next_frontier[predecessor], 1, memory_order_relaxed);
+                resolved++;
+            }
+        }
+    }
+    return resolved;
+}
+
+/////////////////////////////////////////////////////////////////////
+// run_pass(): Thread function working on [begin, end) of a table.
+//             The init pass values every position by the moves
+//             leaving the table, the other passes retract the moves
+//             into the positions resolved in the previous pass.
+/////////////////////////////////////////////////////////////////////
+PRIVATE void *run_pass(void *argument)
+{
+    Pass *pass = argument;
+    Table *table = pass->table;
+
+    for (uint32_t index = pass->begin; index < pass->end; index++)
+    {
+        if (pass->init)
+        {
+            if (init_position(pass->generator, table, index))
+            {
+                table->next_frontier[index] = 1;
+                pass->resolved++;
+            }
+        }
+        else if (table->frontier[index])
+        {
+            pass->resolved += retract_position(table, index);
+        }
+    }
+    return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////
+// run_passes(): Runs one pass over table, split into equal parts for
+//               the threads of generator.
+//               Returns the number of positions resolved.
+/////////////////////////////////////////////////////////////////////
+PRIVATE long run_passes(Generator *generator, Table *table, bool init)
+{
+    pthread_t threads[MAX_THREADS];
+    Pass passes[MAX_THREADS];
+    uint32_t part = table->size / generator->threads + 1;
+    long resolved = 0;
+
+    for (int i = 0; i < generator->threads; i++)
+    {
+        uint64_t begin = (uint64_t) i * part;
+        uint64_t end = begin + part;
+        begin = (begin > table->size) ? table->size : begin;
+        end = (end > table->size) ? table->size : end;
+        passes[i] = (Pass) { generator, table, begin, end, init, 0 };
+        if (0 != pthread_create(&threads[i], NULL, run_pass, &passes[i]))
+        {
+            fprintf(stderr, "error: %s: creating thread failed; aborting\n", __func__);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < generator->threads; i++)
+    {
+        pthread_join(threads[i], NULL);
+        resolved += passes[i].resolved;
+    }
+    return resolved;
+}
+
+/////////////////////////////////////////////////////////////////////
+// write_table(): Writes the header and the values packed into two
+//                bits each.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool write_table(const Table *table, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (NULL == file)
+        return false;
+
+    uint8_t header[BITBASE_HEADER_SIZE] = {'C', 'H', 'B', 'B', BITBASE_VERSION, table->pieces_number};
+    memcpy(header + 6, table->material, strlen(table->material));
+    size_t packed_size = (table->size + 3) / 4;
+    uint8_t *packed = mem_calloc(MEM_BITBASE, packed_size, 1);
+    for (uint32_t i = 0; i < table->size; i++)
+        packed[i / 4] |= table->values[i] << (2 * (i % 4));
+
+    bool written = (1 == fwrite(header, sizeof(header), 1, file))
+                && (1 == fwrite(packed, packed_size, 1, file));
+    mem_free(MEM_BITBASE, packed, packed_size);
+    return (0 == fclose(file)) && written;
+}
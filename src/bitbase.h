@@ -0,0 +1,77 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+/********************************************************************
+ * bitbase.h                                                        *
+ *                                                                  *
+ * Win/draw/loss tables for endings with up to BITBASE_MAX_PIECES   *
+ * pieces (kings included), generated by retrograde analysis.       *
+ *                                                                  *
+ * A table is named by its material, white first, e.g. "KQvK" or   *
+ * "KRvKP". The side with more material is always stored as white,  *
+ * positions with colors the other way round are mirrored when      *
+ * probing. Castling and en passant are not part of the tables.     *
+ *                                                                  *
+ * File format:                                                     *
+ *   16 byte header: "CHBB", version, number of pieces, material    *
+ *   2 bits per position: draw, win, loss or illegal (for the side  *
+ *   to move), four positions per byte.                             *
+ * The position index is                                            *
+ *   to_move + 2 * (square_0 + 64 * (square_1 + 64 * ...))          *
+ * with square = 8 * row + column and the pieces ordered as in the  *
+ * name. So a probe is one memory access into the mapped file.      *
+ ********************************************************************/
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include "core_functions.h"
+#include <stdbool.h>
+
+#define BITBASE_MAX_PIECES 4
+
+typedef struct bitbase *Bitbase;
+
+/********************************************************************
+ * Bitbase_value: The result of a position for the side to move.   *
+ ********************************************************************/
+typedef enum bitbase_value {
+    BITBASE_DRAW, BITBASE_WIN, BITBASE_LOSS, BITBASE_UNKNOWN,
+} Bitbase_value;
+
+/********************************************************************
+ * bitbase_generate: Generates the table for material and writes it *
+ *                   to path. Tables of endings reached by captures *
+ *                   and promotions are generated in memory first.  *
+ *                   Every pass over the positions is split among   *
+ *                   threads threads.                               *
+ *                   Returns false if material is not a valid name  *
+ *                   or path can not be written.                    *
+ ********************************************************************/
+bool bitbase_generate(const char *material, const char *path, int threads);
+
+/********************************************************************
+ * bitbase_open: Maps the table at path into memory.                *
+ *               Returns NULL if the file can not be opened or is   *
+ *               not a valid table.                                 *
+ ********************************************************************/
+Bitbase bitbase_open(const char *path);
+
+/********************************************************************
+ * bitbase_close: Unmaps the table and frees it.                    *
+ ********************************************************************/
+void bitbase_close(Bitbase bitbase);
+
+/********************************************************************
+ * bitbase_material: Returns the name of the table, e.g. "KQvK".    *
+ ********************************************************************/
+const char *bitbase_material(const Bitbase bitbase);
+
+/********************************************************************
+ * bitbase_probe: Returns the value of state for the player to      *
+ *                move. Returns BITBASE_UNKNOWN if the material of  *
+ *                state does not belong to bitbase or the position  *
+ *                is illegal.                                       *
+ ********************************************************************/
+Bitbase_value bitbase_probe(const Bitbase bitbase, const Game_state *state);
+
+#endif
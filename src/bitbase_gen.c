@@ -0,0 +1,61 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+//
+// bitbase_gen.c
+// command line tool generating bitbases
+//
+// usage: bitbase_gen.x [-j threads] [-d directory] material...
+// e.g.:  bitbase_gen.x -j 8 KPvK KRvKP
+// writes the tables as <material>.bb into directory (default: ".")
+//
+
+#include "bitbase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+    int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    const char *directory = ".";
+    int option;
+
+    while (-1 != (option = getopt(argc, argv, "j:d:")))
+    {
+        switch (option)
+        {
+            case 'j':   threads = atoi(optarg);
+                        break;
+            case 'd':   directory = optarg;
+                        break;
+            default:    fprintf(stderr, "usage: %s [-j threads] [-d directory] material...\n", argv[0]);
+                        return EXIT_FAILURE;
+        }
+    }
+    if (optind == argc)
+    {
+        fprintf(stderr, "usage: %s [-j threads] [-d directory] material...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    for (int i = optind; i < argc; i++)
+    {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s.bb", directory, argv[i]);
+        printf("generating %s ... ", path);
+        fflush(stdout);
+        if (bitbase_generate(argv[i], path, threads))
+        {
+            printf("done\n");
+        }
+        else
+        {
+            printf("failed\n");
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
@@ -119,11 +119,12 @@ char *board_string(Game_state *state)
 /********************************************************************
  * set_test_game_state: Takes a Game_state and sets it's values to  *
  *                 default testing value.                           *
- *                 Ignores last_move, king_white, king_black and    *
- *                 *previous_game_state.                            *
+ *                 Ignores last_move, king_white and king_black.    *
  ********************************************************************/
 void set_test_game_state(Game_state *state)
 {
+    state->previous_state = NULL;
+    state->changes_number = 0;
     state->move_number = 1;
     state->uneventful_moves = 0;
     state->board_occurences = 1;
@@ -10,6 +10,8 @@
 #endif
 
 #include "core_functions.h"
+#include "mem_utilities.h"
+#include "zobrist.h"
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -44,7 +46,8 @@ int board_repeated(Game_state *state)
 {
     Game_state *ptr = state;
 
-    while (ptr->move_number > 2)
+    // states set up from a board string have no history
+    while ((ptr->move_number > 2) && (NULL != ptr->previous_state) && (NULL != ptr->previous_state->previous_state))
     {
         // It is enough to examine every second boards-state because two of them are not the same, when different players are to move.
         ptr = ptr->previous_state->previous_state;
@@ -67,12 +70,15 @@ int board_repeated(Game_state *state)
  * apply_move: Returns a pointer to a dynamically allocated         *
  *             Game_state which represents the state of the game    *
  *             after move was performed in state.                   *
+ *             It is counted as MEM_GAME_STATE (see mem_utilities.h)*
+ *             and can be freed with free() as long as no other     *
+ *             Mem_backend is set.                                  *
  *             Returns NULL if memoryallocation fails.              *
  *             Assumes that move is legal.                          *
  ********************************************************************/
 Game_state *apply_move(Game_state *state, Move_i move)
 {
-    Game_state *new_state = malloc(sizeof(*new_state));
+    Game_state *new_state = mem_try_alloc(MEM_GAME_STATE, sizeof(*new_state));
     if (NULL == new_state)
         return NULL;
 
@@ -81,6 +87,10 @@ Game_state *apply_move(Game_state *state, Move_i move)
 
     Color_i moving_player = player_active(state);
 
+    // castling rights, en passant and the player to move are added back at the end
+    new_state->key ^= zobrist_extras(state);
+    new_state->changes_number = 0;
+
     // processing pawn-move-effects
     // and updating new_state->uneventful_moves
     new_state->pawn_upgradable = false;
@@ -93,7 +103,7 @@ Game_state *apply_move(Game_state *state, Move_i move)
         if ((move.from.column != move.to.column)
          && (EMPTY == state->board[move.to.row][move.to.column].kind))
         {
-            new_state->board[move.from.row][move.to.column] = (Piece_i) {NONE_i, EMPTY};
+            set_square(new_state, move.from.row, move.to.column, (Piece_i) {NONE_i, EMPTY});
         }
         // checking if pawn can be upgraded (can't happen in the same turn as en passant capturing)
         else if ((0 == move.to.row) || (BOARD_ROWS - 1 == move.to.row))
@@ -118,14 +128,14 @@ Game_state *apply_move(Game_state *state, Move_i move)
         // moving rook in case of kingside castling
         if (move.from.column + 2 == move.to.column)
         {
-            new_state->board[move.from.row][move.from.column + 1] = (Piece_i) {moving_player, ROOK};
-            new_state->board[move.from.row][BOARD_COLUMNS - 1] = (Piece_i) {NONE_i, EMPTY};
+            set_square(new_state, move.from.row, move.from.column + 1, (Piece_i) {moving_player, ROOK});
+            set_square(new_state, move.from.row, BOARD_COLUMNS - 1, (Piece_i) {NONE_i, EMPTY});
         }
         // moving rook in case of queenside castling
         else if (move.from.column - 2 == move.to.column)
         {
-            new_state->board[move.from.row][move.from.column - 1] = (Piece_i) {moving_player, ROOK};
-            new_state->board[move.from.row][0] = (Piece_i) {NONE_i, EMPTY};
+            set_square(new_state, move.from.row, move.from.column - 1, (Piece_i) {moving_player, ROOK});
+            set_square(new_state, move.from.row, 0, (Piece_i) {NONE_i, EMPTY});
         }
 
         // updating king squares and future castling legality
@@ -163,20 +173,42 @@ Game_state *apply_move(Game_state *state, Move_i move)
     }
 
     // move the moving piece
-    new_state->board[move.to.row][move.to.column] = new_state->board[move.from.row][move.from.column];
-    new_state->board[move.from.row][move.from.column] = (Piece_i) {NONE_i, EMPTY};
+    set_square(new_state, move.to.row, move.to.column, new_state->board[move.from.row][move.from.column]);
+    set_square(new_state, move.from.row, move.from.column, (Piece_i) {NONE_i, EMPTY});
 
     // update remaining variablies in new_state
     new_state->move_number++;
     new_state->possible_moves_number = 0;
     update_possible_moves_game(new_state);
     new_state->last_move = (Move_i) {(Square_i) {move.from.row, move.from.column}, (Square_i) {move.to.row, move.to.column}};
+    new_state->key ^= zobrist_extras(new_state);
 
     new_state->board_occurences = board_repeated(new_state);
 
     return new_state;
 }
 
+/********************************************************************
+ * set_square: Puts piece on (row, column) of state->board and      *
+ *             updates state->key and state->pawn_key accordingly.  *
+ ********************************************************************/
+void set_square(Game_state *state, int row, int column, Piece_i piece)
+{
+    Piece_i old_piece = state->board[row][column];
+    uint64_t old_number = zobrist_piece(old_piece, row, column);
+    uint64_t new_number = zobrist_piece(piece, row, column);
+
+    state->key ^= old_number ^ new_number;
+    if (PAWN == old_piece.kind)
+        state->pawn_key ^= old_number;
+    if (PAWN == piece.kind)
+        state->pawn_key ^= new_number;
+    if (GAME_STATE_CHANGES > state->changes_number)
+        state->changes[state->changes_number] = (Square_change) {(Square_i) {row, column}, old_piece, piece};
+    state->changes_number++;
+    state->board[row][column] = piece;
+}
+
 /********************************************************************
  * player_active: Returns the color of the active player.           *
  ********************************************************************/
@@ -590,10 +622,10 @@ PRIVATE inline void write_king_possible_moves(Game_state *state, Square_i *squar
     {
         for (column = square-> column - 1; column <= square->column + 1; ++column)
         {
-            if ((active_player == state->board[row][column].color)
-             || (row < 0 || row >= BOARD_ROWS)
+            if ((row < 0 || row >= BOARD_ROWS)
+             || (column < 0 || column >= BOARD_COLUMNS)
              || (row == square->row && column == square->column)
-             || (column < 0 || column >= BOARD_COLUMNS))
+             || (active_player == state->board[row][column].color))
                 continue;
             else if (!in_check_after_move(state, (Move_i) {*square, (Square_i) {row, column}}))
             {
@@ -867,14 +899,14 @@ bool is_attacked_by(Game_state *game_state, Square_i square, Color_i attacking_p
 
     /* check pawn */
     int pawn_row_modifier = (WHITE_i == attacking_player) ? -1 : 1;
-    if (square.row + pawn_row_modifier >= 0 || square.row + pawn_row_modifier < BOARD_ROWS)
+    if (square.row + pawn_row_modifier >= 0 && square.row + pawn_row_modifier < BOARD_ROWS)
     {
         if ((square.column - 1 >= 0)
          && (PAWN == game_state->board[square.row + pawn_row_modifier][square.column - 1].kind)
          && (attacking_player == game_state->board[square.row + pawn_row_modifier][square.column - 1].color))
             return true;
 
-        if ((square.column + 1 >= 0)
+        if ((square.column + 1 < BOARD_COLUMNS)
          && (PAWN == game_state->board[square.row + pawn_row_modifier][square.column + 1].kind)
          && (attacking_player == game_state->board[square.row + pawn_row_modifier][square.column + 1].color))
             return true;
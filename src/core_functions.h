@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #define BOARD_ROWS 8
 #define BOARD_COLUMNS 8
@@ -33,6 +34,20 @@ typedef struct piece_i {
     Kind_i kind;
 } Piece_i;
 
+/********************************************************************
+ * Square_change: One call of set_square(). Every Game_state        *
+ *                records the changes of its board since the        *
+ *                previous state, so evaluations can be updated     *
+ *                instead of being recomputed.                      *
+ ********************************************************************/
+#define GAME_STATE_CHANGES 8
+
+typedef struct square_change {
+    Square_i square;
+    Piece_i old_piece;
+    Piece_i new_piece;
+} Square_change;
+
 typedef struct game_state {
     int move_number;
     int uneventful_moves;
@@ -44,6 +59,10 @@ typedef struct game_state {
     bool pawn_upgradable;
     Move_i last_move;
     Piece_i board[BOARD_ROWS][BOARD_COLUMNS];
+    uint64_t key;           // zobrist key of the position (see zobrist.h)
+    uint64_t pawn_key;      // zobrist key of the pawns only
+    Square_change changes[GAME_STATE_CHANGES];
+    int changes_number;     // can be more than GAME_STATE_CHANGES, then not all changes are recorded
     Square_i king_white;
     Square_i king_black;
     bool possible_moves[BOARD_ROWS][BOARD_COLUMNS][BOARD_ROWS][BOARD_COLUMNS];
@@ -76,6 +95,15 @@ int board_repeated(Game_state *state);
  ********************************************************************/
 Game_state *apply_move(Game_state *state, Move_i move);
 
+/********************************************************************
+ * set_square: Puts piece on (row, column) of state->board,         *
+ *             updates state->key and state->pawn_key accordingly   *
+ *             and records the change in state->changes.            *
+ *             All changes of the board of a state with valid keys  *
+ *             have to go through here.                             *
+ ********************************************************************/
+void set_square(Game_state *state, int row, int column, Piece_i piece);
+
 /********************************************************************
  * player_active: Returns the color of the active player.           *
  ********************************************************************/
@@ -11,7 +11,10 @@
 
 #include "core_functions.h"
 #include "core_interface.h"
+#include "mem_utilities.h"
 #include "san_parsing.h"
+#include "zobrist.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
@@ -62,12 +65,74 @@ PRIVATE Letter_piece piece_to_letter_interf(const Piece_i *piece);
  *              Returns
  *              { {-1,-1}, {0,0} } if move is ambigious or
  *              { {-1,-1}, {1,1} } if move is illegal
- *              Does not error-check. Correct format is assumed.
- *              !!!! draw claim/proposal and pawn creation not included
- *              (also not in input)
+ *              Trailing check/mate suffixes ('+', '#') are accepted
+ *              and ignored.
+ *              The move is resolved by a single pass over the
+ *              already generated possible_moves of the current
+ *              state. No moves are applied to find it.
+ *              For promotions only the squares are returned, the
+ *              piece has to be passed to upgrade_pawn() after
+ *              move_piece().
  ********************************************************************/
 Move san_to_move(const char *san, const Game game)
 {
+    const Move ambiguous = { (Square) {-1,-1}, (Square) {0,0} };
+    const Move illegal = { (Square) {-1,-1}, (Square) {1,1} };
+
+    San_move parsed = san_lex(san);
+    if (INVALID_SAN == parsed.type)
+        return illegal;
+
+    Game_state *state = game->current_state;
+    Color_i active_player = player_active(state);
+
+    // castling is the king moving two squares
+    if ((CASTLE_LEFT == parsed.type) || (CASTLE_RIGHT == parsed.type))
+    {
+        int row = (WHITE_i == active_player) ? 0 : BOARD_ROWS - 1;
+        int to_column = (CASTLE_RIGHT == parsed.type) ? 6 : 2;
+        if ((KING == state->board[row][4].kind)
+         && (state->possible_moves[row][4][row][to_column]))
+            return (Move) { (Square) {row, 4}, (Square) {row, to_column} };
+        return illegal;
+    }
+
+    Kind_i kind = letter_to_piece(parsed.piece).kind;
+    Square_i to = { parsed.to_rank, parsed.to_file };
+    int from_row = parsed.from_rank;
+    int from_column = parsed.from_file;
+
+    // captures need something to capture (en passant targets an empty square)
+    if (parsed.capture != (EMPTY != state->board[to.row][to.column].kind))
+    {
+        if (!parsed.capture || (PAWN != kind))
+            return illegal;
+    }
+
+    // single pass over all squares, which could be the origin of the move
+    Move found = illegal;
+    int candidates = 0;
+    for (int i = 0; i < BOARD_ROWS; i++)
+    {
+        if ((-1 != from_row) && (i != from_row))
+            continue;
+        for (int j = 0; j < BOARD_COLUMNS; j++)
+        {
+            if ((-1 != from_column) && (j != from_column))
+                continue;
+            if ((kind == state->board[i][j].kind)
+             && (active_player == state->board[i][j].color)
+             && (state->possible_moves[i][j][to.row][to.column]))
+            {
+                found = (Move) { (Square) {i, j}, (Square) {to.row, to.column} };
+                candidates++;
+            }
+        }
+    }
+
+    if (candidates > 1)
+        return ambiguous;
+    return found;
 }
 
 /********************************************************************
@@ -76,19 +141,8 @@ Move san_to_move(const char *san, const Game game)
  ********************************************************************/
 Game create_game(void)
 {
-    Game new_game = malloc(sizeof(new_game));
-    if (NULL == new_game)
-    {
-        printf("error: %s: memory-allocation for new game failed", __func__);
-        exit(EXIT_FAILURE);
-    }
-
-    Game_state *beg_state = malloc(sizeof(*beg_state));
-    if (NULL == beg_state)
-    {
-        printf("error: %s: memory-allocation for new game failed", __func__);
-        exit(EXIT_FAILURE);
-    }
+    Game new_game = mem_alloc(MEM_GAME_STATE, sizeof(*new_game));
+    Game_state *beg_state = mem_alloc(MEM_GAME_STATE, sizeof(*beg_state));
 
     set_game_state(beg_state, STARTING_BOARD);
 
@@ -109,10 +163,10 @@ void destroy_game(Game game)
     {
         temp = game->current_state;
         game->current_state = game->current_state->previous_state;
-        free(temp);
+        mem_free(MEM_GAME_STATE, temp, sizeof(*temp));
     }
-    free(game->current_state);
-    free(game);
+    mem_free(MEM_GAME_STATE, game->current_state, sizeof(*game->current_state));
+    mem_free(MEM_GAME_STATE, game, sizeof(*game));
 }
 
 /********************************************************************
@@ -121,21 +175,11 @@ void destroy_game(Game game)
  ********************************************************************/
 Game duplicate_game(Game original_game)
 {
-    Game duplicate_game = malloc(sizeof(duplicate_game));
-    if (NULL == duplicate_game)
-    {
-        printf("error: %s: memory-allocation for duplicate game failed", __func__);
-        exit(EXIT_FAILURE);
-    }
+    Game duplicate_game = mem_alloc(MEM_GAME_STATE, sizeof(*duplicate_game));
 
     Game_state *original_state = original_game->current_state;
 
-    Game_state *duplicate_state = malloc(sizeof(*duplicate_state));
-    if (NULL == duplicate_state)
-    {
-        printf("error: %s: memory-allocation for duplicate gamestate failed", __func__);
-        exit(EXIT_FAILURE);
-    }
+    Game_state *duplicate_state = mem_alloc(MEM_GAME_STATE, sizeof(*duplicate_state));
     *duplicate_state = *original_state;
 
     duplicate_game->current_state = duplicate_state;
@@ -144,12 +188,7 @@ Game duplicate_game(Game original_game)
     {
         original_state = original_state->previous_state;
 
-        duplicate_state->previous_state = malloc(sizeof(*duplicate_state->previous_state));
-        if (NULL == duplicate_state->previous_state)
-        {
-            printf("error: %s: memory-allocation for duplicate gamestate failed", __func__);
-            exit(EXIT_FAILURE);
-        }
+        duplicate_state->previous_state = mem_alloc(MEM_GAME_STATE, sizeof(*duplicate_state->previous_state));
         *duplicate_state->previous_state = *original_state;
         duplicate_state = duplicate_state->previous_state;
     }
@@ -181,6 +220,55 @@ bool move_piece(Game game, const Move move)
     return false;
 }
 
+/********************************************************************
+ * move_possible: Returns true if move is legal in the current      *
+ *                state of game, without performing it.             *
+ *                Squares outside of the board are never legal.     *
+ ********************************************************************/
+bool move_possible(const Game game, const Move move)
+{
+    if ((0 > move.from.row) || (BOARD_ROWS <= move.from.row)
+     || (0 > move.from.column) || (BOARD_COLUMNS <= move.from.column)
+     || (0 > move.to.row) || (BOARD_ROWS <= move.to.row)
+     || (0 > move.to.column) || (BOARD_COLUMNS <= move.to.column))
+        return false;
+    return game->current_state->possible_moves[move.from.row][move.from.column][move.to.row][move.to.column];
+}
+
+/********************************************************************
+ * position_key: Returns the zobrist key of the current state of    *
+ *               game (see zobrist.h).                              *
+ ********************************************************************/
+uint64_t position_key(const Game game)
+{
+    return game->current_state->key;
+}
+
+/********************************************************************
+ * piece_at: Returns the letter of the piece on square, in the same *
+ *           letters as current_board().                            *
+ ********************************************************************/
+Letter_piece piece_at(const Game game, Square square)
+{
+    return piece_to_letter_interf(&game->current_state->board[square.row][square.column]);
+}
+
+/********************************************************************
+ * last_changes: Writes the squares whose piece changed with the    *
+ *               last move to squares and returns their number, -1  *
+ *               if they are not known.                             *
+ ********************************************************************/
+int last_changes(const Game game, Square squares[GAME_STATE_CHANGES])
+{
+    const Game_state *state = game->current_state;
+    if ((NULL == state->previous_state) || (GAME_STATE_CHANGES < state->changes_number))
+        return -1;
+
+    for (int i = 0; i < state->changes_number; i++)
+        squares[i] = (Square) {state->changes[i].square.row, state->changes[i].square.column};
+    return state->changes_number;
+}
+
 /********************************************************************
  * claim_remis_move: Returns true if move with remis claim will     *
  *                   lead to remis by threefold-repetition-rule.    *
@@ -197,14 +285,9 @@ bool claim_remis_move(Game game, Move move)
         exit(EXIT_FAILURE);
     }
 
-    if (3 <= remis_state->board_occurences)
-    {
-        free(remis_state);
-        return true;
-    }
-
-    return false;
-    free(remis_state);
+    bool remis = (3 <= remis_state->board_occurences);
+    mem_free(MEM_GAME_STATE, remis_state, sizeof(*remis_state));
+    return remis;
 }
 
 /********************************************************************
@@ -241,8 +324,8 @@ Square pawn_upgradable(const Game game)
  ********************************************************************/
 void upgrade_pawn(Game game, const Letter_piece piece)
 {
-    game->current_state->board[game->current_state->last_move.to.row][game->current_state->last_move.to.column]
-        = (Piece_i) {letter_to_piece(piece).color, letter_to_piece(piece).kind};
+    set_square(game->current_state, game->current_state->last_move.to.row, game->current_state->last_move.to.column,
+               letter_to_piece(piece));
 }
 
 /********************************************************************
@@ -442,4 +525,8 @@ PRIVATE void set_game_state(Game_state *state, const Letter_piece *board)
     }
 
     state->previous_state = NULL;
+
+    state->key = zobrist_key(state);
+    state->pawn_key = zobrist_pawn_key(state);
+    state->changes_number = 0;
 }
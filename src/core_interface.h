@@ -24,6 +24,7 @@
 
 #include "core_functions.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct game *Game;
 
@@ -69,9 +70,12 @@ enum letter_piece
  *              Returns
  *              { {-1,-1}, {0,0} } if move is ambigious or
  *              { {-1,-1}, {1,1} } if move is illegal
- *              Does not error-check. Correct format is assumed.
- *              !!!! draw claim/proposal and pawn creation not included
- *              (also not in input)
+ *              Malformed san is treated as illegal.
+ *              Trailing check/mate suffixes ('+', '#') are ignored.
+ *              For promotions only the squares are returned, the
+ *              piece has to be passed to upgrade_pawn() after
+ *              move_piece().
+ *              !!!! draw claim/proposal not included
  ********************************************************************/
 Move san_to_move(const char *san, const Game game);
 
@@ -99,6 +103,18 @@ Game duplicate_game(const Game game);
  ********************************************************************/
 bool move_piece(Game game, const Move move);
 
+/********************************************************************
+ * move_possible: Returns true if move is legal in the current      *
+ *                state of game, without performing it.             *
+ ********************************************************************/
+bool move_possible(const Game game, const Move move);
+
+/********************************************************************
+ * position_key: Returns the zobrist key of the current state of    *
+ *               game (see zobrist.h).                              *
+ ********************************************************************/
+uint64_t position_key(const Game game);
+
 /********************************************************************
  * claim_remis_move: Returns true if move with remis claim will     *
  *                   lead to remis.                                 *
@@ -139,4 +155,20 @@ int victory_state(const Game game);
  ********************************************************************/
 const Letter_piece *current_board(Game game);
 
+/********************************************************************
+ * piece_at: Returns the letter of the piece on square, in the same *
+ *           letters as current_board().                            *
+ ********************************************************************/
+Letter_piece piece_at(const Game game, Square square);
+
+/********************************************************************
+ * last_changes: Writes the squares whose piece changed with the    *
+ *               last move (and the upgrade of a pawn after it) to  *
+ *               squares and returns their number. A square can be  *
+ *               written more than once.                            *
+ *               Returns -1 if the changes are not known, e.g. for  *
+ *               a new game.                                        *
+ ********************************************************************/
+int last_changes(const Game game, Square squares[GAME_STATE_CHANGES]);
+
 #endif
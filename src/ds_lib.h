@@ -5,21 +5,198 @@
  * ds_lib
  * provides the following data-structures:
  * 1. int stack
+ * 2. stacks of any type, see STACK_DECLARE() and STACK_DEFINE()
  ********************************************************************/
 #ifndef DS_LIB_H
 #define DS_LIB_H
 
+#include "mem_utilities.h"
+#include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-typedef struct stack_int *Stack_int;
+// capacity of a stack after its first allocation
+#define STACK_MIN_CAPACITY 8
 
-Stack_int stack_int_create(void);
-void stack_int_destroy(Stack_int stack);
-void stack_int_make_empty(Stack_int stack);
-bool stack_int_push(Stack_int stack, int n);
-bool stack_int_pop(Stack_int stack, int *n);
-bool stack_int_is_full(Stack_int stack);
-bool stack_int_is_empty(Stack_int stack); 
-bool stack_int_peek(Stack_int stack, int *n); 
+/********************************************************************
+ * STACK_DECLARE: Declares the stack type Name (a pointer to the
+ *                opaque struct prefix) holding elements of type and
+ *                the following functions:
+ *
+ *   Name prefix_create(void)
+ *   void prefix_destroy(Name stack)
+ *   void prefix_make_empty(Name stack)
+ *       Keeps the memory, see prefix_shrink_to_fit().
+ *   bool prefix_push(Name stack, type value)
+ *   bool prefix_pop(Name stack, type *value)
+ *   bool prefix_peek(Name stack, type *value)
+ *       pop and peek return false if stack is empty.
+ *   bool prefix_is_full(Name stack)
+ *       true if the next push has to grow the stack.
+ *   bool prefix_is_empty(Name stack)
+ *   int prefix_size(Name stack)
+ *   bool prefix_reserve(Name stack, int capacity)
+ *       Makes room for capacity elements, so pushing up to
+ *       capacity elements does not allocate.
+ *   bool prefix_push_many(Name stack, const type *values, int number)
+ *       Pushes values[0] first, values[number - 1] ends on top.
+ *   int prefix_pop_many(Name stack, type *values, int number)
+ *       Pops up to number elements, the top one to values[0].
+ *       Returns the number of popped elements.
+ *   void prefix_shrink_to_fit(Name stack)
+ *       Frees the memory not used by the elements.
+ *
+ * The elements are kept in one array, which doubles when it is
+ * full. push, push_many and reserve return false if the stack
+ * would get more than INT_MAX elements, failed allocations abort
+ * the program. The memory is counted as MEM_GENERAL (see
+ * mem_dump()).
+ ********************************************************************/
+#define STACK_DECLARE(Name, prefix, type) \
+typedef struct prefix *Name; \
+Name prefix##_create(void); \
+void prefix##_destroy(Name stack); \
+void prefix##_make_empty(Name stack); \
+bool prefix##_push(Name stack, type value); \
+bool prefix##_pop(Name stack, type *value); \
+bool prefix##_peek(Name stack, type *value); \
+bool prefix##_is_full(Name stack); \
+bool prefix##_is_empty(Name stack); \
+int prefix##_size(Name stack); \
+bool prefix##_reserve(Name stack, int capacity); \
+bool prefix##_push_many(Name stack, const type *values, int number); \
+int prefix##_pop_many(Name stack, type *values, int number); \
+void prefix##_shrink_to_fit(Name stack);
+
+/********************************************************************
+ * STACK_DEFINE: Defines the functions declared by STACK_DECLARE()
+ *               with the same arguments. Has to be used in exactly
+ *               one source file.
+ ********************************************************************/
+#define STACK_DEFINE(Name, prefix, type) \
+struct prefix { \
+    type *values; \
+    int size; \
+    int capacity; \
+}; \
+\
+Name prefix##_create(void) \
+{ \
+    Name new_stack = mem_alloc(MEM_GENERAL, sizeof(*new_stack)); \
+    new_stack->values = NULL; \
+    new_stack->size = 0; \
+    new_stack->capacity = 0; \
+    return new_stack; \
+} \
+\
+void prefix##_destroy(Name stack) \
+{ \
+    mem_free(MEM_GENERAL, stack->values, stack->capacity * sizeof(type)); \
+    mem_free(MEM_GENERAL, stack, sizeof(*stack)); \
+} \
+\
+void prefix##_make_empty(Name stack) \
+{ \
+    stack->size = 0; \
+} \
+\
+bool prefix##_reserve(Name stack, int capacity) \
+{ \
+    if ((0 > capacity) || ((size_t) capacity > SIZE_MAX / sizeof(type))) \
+        return false; \
+    if (capacity <= stack->capacity) \
+        return true; \
+    stack->values = mem_realloc(MEM_GENERAL, stack->values, stack->capacity * sizeof(type), capacity * sizeof(type)); \
+    stack->capacity = capacity; \
+    return true; \
+} \
+\
+bool prefix##_push_many(Name stack, const type *values, int number) \
+{ \
+    if ((0 > number) || (number > INT_MAX - stack->size)) \
+        return false; \
+    if (stack->size + number > stack->capacity) \
+    { \
+        int capacity = (stack->capacity > INT_MAX / 2) ? INT_MAX : 2 * stack->capacity; \
+        if (capacity < STACK_MIN_CAPACITY) \
+            capacity = STACK_MIN_CAPACITY; \
+        if (capacity < stack->size + number) \
+            capacity = stack->size + number; \
+        if (!prefix##_reserve(stack, capacity)) \
+            return false; \
+    } \
+    if (0 < number) \
+        memcpy(stack->values + stack->size, values, number * sizeof(type)); \
+    stack->size += number; \
+    return true; \
+} \
+\
+bool prefix##_push(Name stack, type value) \
+{ \
+    if (stack->size < stack->capacity) \
+    { \
+        stack->values[stack->size++] = value; \
+        return true; \
+    } \
+    return prefix##_push_many(stack, &value, 1); \
+} \
+\
+int prefix##_pop_many(Name stack, type *values, int number) \
+{ \
+    if (number > stack->size) \
+        number = stack->size; \
+    for (int i = 0; i < number; i++) \
+        values[i] = stack->values[--stack->size]; \
+    return (0 < number) ? number : 0; \
+} \
+\
+bool prefix##_pop(Name stack, type *value) \
+{ \
+    if (0 == stack->size) \
+        return false; \
+    *value = stack->values[--stack->size]; \
+    return true; \
+} \
+\
+bool prefix##_peek(Name stack, type *value) \
+{ \
+    if (0 == stack->size) \
+        return false; \
+    *value = stack->values[stack->size - 1]; \
+    return true; \
+} \
+\
+bool prefix##_is_full(Name stack) \
+{ \
+    return stack->size == stack->capacity; \
+} \
+\
+bool prefix##_is_empty(Name stack) \
+{ \
+    return 0 == stack->size; \
+} \
+\
+int prefix##_size(Name stack) \
+{ \
+    return stack->size; \
+} \
+\
+void prefix##_shrink_to_fit(Name stack) \
+{ \
+    if (stack->size == stack->capacity) \
+        return; \
+    if (0 == stack->size) \
+    { \
+        mem_free(MEM_GENERAL, stack->values, stack->capacity * sizeof(type)); \
+        stack->values = NULL; \
+    } \
+    else \
+        stack->values = mem_realloc(MEM_GENERAL, stack->values, stack->capacity * sizeof(type), stack->size * sizeof(type)); \
+    stack->capacity = stack->size; \
+}
+
+STACK_DECLARE(Stack_int, stack_int, int)
 
 #endif
@@ -0,0 +1,329 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+#define PRIVATE static
+
+#include "evaluation.h"
+#include "core_functions.h"
+#include "mem_utilities.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+struct pawn_table
+{
+    Pawn_entry *entries;
+    uint64_t mask;
+    long hits;
+    long misses;
+};
+
+// data is the score as unsigned 32 bit value, check is key ^ data
+typedef struct eval_cache_entry
+{
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+} Eval_cache_entry;
+
+struct eval_cache
+{
+    Eval_cache_entry *entries;
+    uint64_t mask;
+    atomic_long hits;
+    atomic_long misses;
+};
+
+PRIVATE bool pawn_on(uint64_t pawns, int row, int column);
+PRIVATE int evaluate_pawn(uint64_t own, uint64_t enemy, int row, int column, int direction, bool *passed);
+
+/********************************************************************
+ * pawn_table_create: Creates a Pawn_table with at least            *
+ *                    entries_number entries.                       *
+ ********************************************************************/
+Pawn_table pawn_table_create(int entries_number)
+{
+    uint64_t size = 1;
+    while (size < (uint64_t) entries_number)
+        size *= 2;
+
+    Pawn_table pawn_table = mem_alloc(MEM_EVALUATION, sizeof(*pawn_table));
+    pawn_table->entries = mem_calloc(MEM_EVALUATION, size, sizeof(*pawn_table->entries));
+    pawn_table->mask = size - 1;
+    pawn_table->hits = 0;
+    pawn_table->misses = 0;
+    return pawn_table;
+}
+
+/********************************************************************
+ * pawn_table_destroy: Frees pawn_table.                            *
+ ********************************************************************/
+void pawn_table_destroy(Pawn_table pawn_table)
+{
+    mem_free(MEM_EVALUATION, pawn_table->entries, (pawn_table->mask + 1) * sizeof(*pawn_table->entries));
+    mem_free(MEM_EVALUATION, pawn_table, sizeof(*pawn_table));
+}
+
+/********************************************************************
+ * pawn_table_probe: The entry is chosen by the lowest bits of the  *
+ *                   key, the whole key is compared.                *
+ ********************************************************************/
+const Pawn_entry *pawn_table_probe(Pawn_table pawn_table, const Game_state *state)
+{
+    Pawn_entry *entry = &pawn_table->entries[state->pawn_key & pawn_table->mask];
+    if (entry->used && (entry->key == state->pawn_key))
+    {
+        pawn_table->hits++;
+        return entry;
+    }
+
+    pawn_table->misses++;
+    *entry = evaluate_pawns(state);
+    return entry;
+}
+
+/********************************************************************
+ * pawn_table_statistics: Writes the number of hits and misses.     *
+ ********************************************************************/
+void pawn_table_statistics(const Pawn_table pawn_table, long *hits, long *misses)
+{
+    *hits = pawn_table->hits;
+    *misses = pawn_table->misses;
+}
+
+/********************************************************************
+ * evaluate_pawns: Collects the pawns of both players into bit      *
+ *                 sets and evaluates every pawn on its own.        *
+ ********************************************************************/
+Pawn_entry evaluate_pawns(const Game_state *state)
+{
+    uint64_t pawns[2] = {0, 0};
+    for (int i = 0; i < BOARD_ROWS; i++)
+    {
+        for (int j = 0; j < BOARD_COLUMNS; j++)
+        {
+            if (PAWN == state->board[i][j].kind)
+                pawns[(WHITE_i == state->board[i][j].color) ? 0 : 1] |= 1ULL << (8 * i + j);
+        }
+    }
+
+    Pawn_entry entry = { .key = state->pawn_key, .score = 0, .passed = {0, 0}, .used = true };
+    for (int color = 0; color < 2; color++)
+    {
+        int sign = (0 == color) ? 1 : -1;
+        for (int j = 0; j < BOARD_COLUMNS; j++)
+        {
+            int on_column = 0;
+            for (int i = 0; i < BOARD_ROWS; i++)
+            {
+                if (!pawn_on(pawns[color], i, j))
+                    continue;
+                on_column++;
+                bool passed;
+                entry.score += sign * evaluate_pawn(pawns[color], pawns[!color], i, j, sign, &passed);
+                if (passed)
+                    entry.passed[color] |= 1ULL << (8 * i + j);
+            }
+            if (1 < on_column)
+                entry.score += sign * PAWN_DOUBLED * (on_column - 1);
+        }
+    }
+    return entry;
+}
+
+/********************************************************************
+ * evaluate: Material and pawn structure.                           *
+ ********************************************************************/
+int evaluate(const Game_state *state, Pawn_table pawn_table)
+{
+    static const int values[] = {0, VALUE_PAWN, VALUE_KNIGHT, VALUE_BISHOP, VALUE_ROOK, VALUE_QUEEN, 0};
+    int score = 0;
+    for (int i = 0; i < BOARD_ROWS; i++)
+    {
+        for (int j = 0; j < BOARD_COLUMNS; j++)
+        {
+            Piece_i piece = state->board[i][j];
+            score += (WHITE_i == piece.color) ? values[piece.kind] : -values[piece.kind];
+        }
+    }
+
+    if (NULL == pawn_table)
+        score += evaluate_pawns(state).score;
+    else
+        score += pawn_table_probe(pawn_table, state)->score;
+
+    // move_number counts half-moves starting with 1 for white
+    return (1 == state->move_number % 2) ? score : -score;
+}
+
+/********************************************************************
+ * eval_cache_create: Creates an Eval_cache with at least           *
+ *                    entries_number entries.                       *
+ ********************************************************************/
+Eval_cache eval_cache_create(int entries_number)
+{
+    uint64_t size = 1;
+    while (size < (uint64_t) entries_number)
+        size *= 2;
+
+    Eval_cache eval_cache = mem_alloc(MEM_EVALUATION, sizeof(*eval_cache));
+    eval_cache->entries = mem_alloc(MEM_EVALUATION, size * sizeof(*eval_cache->entries));
+    eval_cache->mask = size - 1;
+    eval_cache_clear(eval_cache);
+    return eval_cache;
+}
+
+/********************************************************************
+ * eval_cache_destroy: Frees eval_cache.                            *
+ ********************************************************************/
+void eval_cache_destroy(Eval_cache eval_cache)
+{
+    mem_free(MEM_EVALUATION, eval_cache->entries, (eval_cache->mask + 1) * sizeof(*eval_cache->entries));
+    mem_free(MEM_EVALUATION, eval_cache, sizeof(*eval_cache));
+}
+
+/********************************************************************
+ * eval_cache_clear: An empty entry only matches key 1, which is as *
+ *                   unlikely as any other collision of keys.       *
+ ********************************************************************/
+void eval_cache_clear(Eval_cache eval_cache)
+{
+    for (uint64_t i = 0; i <= eval_cache->mask; i++)
+    {
+        atomic_init(&eval_cache->entries[i].check, 0);
+        atomic_init(&eval_cache->entries[i].data, 1);
+    }
+    atomic_init(&eval_cache->hits, 0);
+    atomic_init(&eval_cache->misses, 0);
+}
+
+/********************************************************************
+ * eval_cache_probe: Both words are read without ordering, a torn   *
+ *                   entry fails the check.                         *
+ ********************************************************************/
+bool eval_cache_probe(Eval_cache eval_cache, uint64_t key, int *score)
+{
+    Eval_cache_entry *entry = &eval_cache->entries[key & eval_cache->mask];
+    uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+    uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+    if ((check ^ data) != key)
+    {
+        atomic_fetch_add_explicit(&eval_cache->misses, 1, memory_order_relaxed);
+        return false;
+    }
+
+    atomic_fetch_add_explicit(&eval_cache->hits, 1, memory_order_relaxed);
+    *score = (int) (int32_t) (uint32_t) data;
+    return true;
+}
+
+/********************************************************************
+ * eval_cache_store: Always replaces, evaluations are cheap to      *
+ *                   recompute.                                     *
+ ********************************************************************/
+void eval_cache_store(Eval_cache eval_cache, uint64_t key, int score)
+{
+    Eval_cache_entry *entry = &eval_cache->entries[key & eval_cache->mask];
+    uint64_t data = (uint32_t) score;
+    atomic_store_explicit(&entry->check, key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&entry->data, data, memory_order_relaxed);
+}
+
+/********************************************************************
+ * eval_cache_statistics: Writes the number of hits and misses.     *
+ ********************************************************************/
+void eval_cache_statistics(const Eval_cache eval_cache, long *hits, long *misses)
+{
+    *hits = atomic_load(&eval_cache->hits);
+    *misses = atomic_load(&eval_cache->misses);
+}
+
+/********************************************************************
+ * evaluate_cached: Evaluates state on a miss.                      *
+ ********************************************************************/
+int evaluate_cached(const Game_state *state, Eval_cache eval_cache, Pawn_table pawn_table)
+{
+    int score;
+    if (eval_cache_probe(eval_cache, state->key, &score))
+        return score;
+
+    score = evaluate(state, pawn_table);
+    eval_cache_store(eval_cache, state->key, score);
+    return score;
+}
+
+/********************************************************************
+ * evaluator_evaluate: Falls back to the handcrafted evaluation if  *
+ *                     no network is loaded.                        *
+ ********************************************************************/
+int evaluator_evaluate(const Evaluator *evaluator, const Game_state *state, const Nnue_accumulator *accumulator)
+{
+    if ((EVALUATOR_HANDCRAFTED == evaluator->kind) || (NULL == evaluator->nnue))
+        return evaluate(state, evaluator->pawn_table);
+
+    if (NULL != accumulator)
+        return nnue_evaluate(evaluator->nnue, accumulator, state);
+
+    Nnue_accumulator fresh;
+    nnue_refresh(evaluator->nnue, &fresh, state);
+    return nnue_evaluate(evaluator->nnue, &fresh, state);
+}
+
+/********************************************************************
+ * pawn_on: Checks if pawns has a pawn on (row, column). Squares    *
+ *          outside of the board are empty.                         *
+ ********************************************************************/
+PRIVATE bool pawn_on(uint64_t pawns, int row, int column)
+{
+    if ((0 > row) || (BOARD_ROWS <= row) || (0 > column) || (BOARD_COLUMNS <= column))
+        return false;
+    return pawns & (1ULL << (8 * row + column));
+}
+
+/********************************************************************
+ * evaluate_pawn: Returns the passed, isolated and backward terms   *
+ *                of the pawn on (row, column) of own, which moves  *
+ *                in direction (1 for white, -1 for black).         *
+ *                *passed is set if no enemy pawn can stop it and   *
+ *                no own pawn is in front of it.                    *
+ ********************************************************************/
+PRIVATE int evaluate_pawn(uint64_t own, uint64_t enemy, int row, int column, int direction, bool *passed)
+{
+    static const int passed_bonus[] = PAWN_PASSED;
+    bool isolated = true;
+    bool supportable = false;
+    bool blocked = false;
+    bool opposed = false;
+
+    for (int i = 0; i < BOARD_ROWS; i++)
+    {
+        bool ahead = (0 < (i - row) * direction);
+        for (int j = column - 1; j <= column + 1; j++)
+        {
+            if (pawn_on(own, i, j) && (j != column))
+            {
+                isolated = false;
+                if (!ahead)
+                    supportable = true;
+            }
+            if (ahead && pawn_on(own, i, j) && (j == column))
+                blocked = true;
+            if (ahead && pawn_on(enemy, i, j))
+                opposed = true;
+        }
+    }
+
+    int score = 0;
+    *passed = !opposed && !blocked;
+    if (*passed)
+        score += passed_bonus[(1 == direction) ? row : BOARD_ROWS - 1 - row];
+
+    int stop = row + direction;
+    if (isolated)
+        score += PAWN_ISOLATED;
+    // backward: can not be protected and the square in front is attacked
+    else if (!*passed && !supportable
+          && (pawn_on(enemy, stop + direction, column - 1) || pawn_on(enemy, stop + direction, column + 1)))
+        score += PAWN_BACKWARD;
+    return score;
+}
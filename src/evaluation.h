@@ -0,0 +1,161 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+/********************************************************************
+ * evaluation.h                                                     *
+ *                                                                  *
+ * Static evaluation of Game_states in centipawns.                  *
+ * The pawn structure only changes with pawn moves, so its          *
+ * evaluation is cached in a Pawn_table keyed by state->pawn_key.   *
+ * Whole evaluations are cached in an Eval_cache keyed by           *
+ * state->key, so transpositions and positions evaluated twice in   *
+ * one search (e.g. at a leaf and at the quiescence entry) are only *
+ * evaluated once.                                                  *
+ ********************************************************************/
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "core_functions.h"
+#include "nnue.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VALUE_PAWN 100
+#define VALUE_KNIGHT 320
+#define VALUE_BISHOP 330
+#define VALUE_ROOK 500
+#define VALUE_QUEEN 900
+
+#define PAWN_DOUBLED -12        // for every pawn more than one on a column
+#define PAWN_ISOLATED -15       // no own pawns on the neighbouring columns
+#define PAWN_BACKWARD -10       // can not be protected by own pawns and can't advance safely
+// bonus for passed pawns by row, seen from the pawn's player
+#define PAWN_PASSED { 0, 10, 15, 25, 45, 75, 120, 0 }
+
+typedef struct pawn_table *Pawn_table;
+typedef struct eval_cache *Eval_cache;
+
+/********************************************************************
+ * Evaluator: Chooses the evaluation at runtime, so the speed and   *
+ *            the strength of both can be compared.                 *
+ ********************************************************************/
+typedef enum evaluator_kind {
+    EVALUATOR_HANDCRAFTED, EVALUATOR_NNUE,
+} Evaluator_kind;
+
+typedef struct evaluator {
+    Evaluator_kind kind;
+    Pawn_table pawn_table;  // EVALUATOR_HANDCRAFTED, can be NULL
+    Nnue nnue;              // EVALUATOR_NNUE
+} Evaluator;
+
+/********************************************************************
+ * Pawn_entry: The evaluation of a pawn structure.                  *
+ *             score is seen from white.                            *
+ *             passed has the bit 8 * row + column set for every    *
+ *             passed pawn, passed[0] for white, passed[1] for      *
+ *             black.                                               *
+ ********************************************************************/
+typedef struct pawn_entry {
+    uint64_t key;
+    int score;
+    uint64_t passed[2];
+    bool used;
+} Pawn_entry;
+
+/********************************************************************
+ * pawn_table_create: Creates a Pawn_table with at least            *
+ *                    entries_number entries (rounded up to a power *
+ *                    of two).                                      *
+ ********************************************************************/
+Pawn_table pawn_table_create(int entries_number);
+
+/********************************************************************
+ * pawn_table_destroy: Frees pawn_table.                            *
+ ********************************************************************/
+void pawn_table_destroy(Pawn_table pawn_table);
+
+/********************************************************************
+ * pawn_table_probe: Returns the entry for the pawns of state,      *
+ *                   evaluating them if they are not in the table   *
+ *                   (replacing the entry stored there before).     *
+ *                   The entry is valid until the next probe.       *
+ ********************************************************************/
+const Pawn_entry *pawn_table_probe(Pawn_table pawn_table, const Game_state *state);
+
+/********************************************************************
+ * pawn_table_statistics: Writes the number of probes finding their *
+ *                        entry to *hits, the others to *misses.    *
+ ********************************************************************/
+void pawn_table_statistics(const Pawn_table pawn_table, long *hits, long *misses);
+
+/********************************************************************
+ * evaluate_pawns: Evaluates the pawn structure of state without    *
+ *                 using a table.                                   *
+ ********************************************************************/
+Pawn_entry evaluate_pawns(const Game_state *state);
+
+/********************************************************************
+ * evaluate: Returns the evaluation of state seen from the player   *
+ *           to move. pawn_table can be NULL.                       *
+ ********************************************************************/
+int evaluate(const Game_state *state, Pawn_table pawn_table);
+
+/********************************************************************
+ * eval_cache_create: Creates an Eval_cache with at least           *
+ *                    entries_number entries (rounded up to a power *
+ *                    of two). Every entry takes 16 bytes.          *
+ *                    The cache can be shared by several threads    *
+ *                    without locking: an entry stores key ^ data   *
+ *                    next to data, so an entry torn by concurrent  *
+ *                    writes does not match its key and is a miss.  *
+ ********************************************************************/
+Eval_cache eval_cache_create(int entries_number);
+
+/********************************************************************
+ * eval_cache_destroy: Frees eval_cache.                            *
+ ********************************************************************/
+void eval_cache_destroy(Eval_cache eval_cache);
+
+/********************************************************************
+ * eval_cache_clear: Empties eval_cache and resets its statistics.  *
+ ********************************************************************/
+void eval_cache_clear(Eval_cache eval_cache);
+
+/********************************************************************
+ * eval_cache_probe: Writes the evaluation stored for key to *score *
+ *                   and returns true, returns false if there is    *
+ *                   none.                                          *
+ ********************************************************************/
+bool eval_cache_probe(Eval_cache eval_cache, uint64_t key, int *score);
+
+/********************************************************************
+ * eval_cache_store: Stores score for key, replacing the entry      *
+ *                   stored there before.                           *
+ ********************************************************************/
+void eval_cache_store(Eval_cache eval_cache, uint64_t key, int score);
+
+/********************************************************************
+ * eval_cache_statistics: Writes the number of probes finding their *
+ *                        entry to *hits, the others to *misses.    *
+ ********************************************************************/
+void eval_cache_statistics(const Eval_cache eval_cache, long *hits, long *misses);
+
+/********************************************************************
+ * evaluate_cached: Same as evaluate(), but looks state up in       *
+ *                  eval_cache first and stores the result there.   *
+ *                  pawn_table can be NULL, it must not be shared   *
+ *                  between threads.                                *
+ ********************************************************************/
+int evaluate_cached(const Game_state *state, Eval_cache eval_cache, Pawn_table pawn_table);
+
+/********************************************************************
+ * evaluator_evaluate: Returns the evaluation of state seen from    *
+ *                     the player to move, as chosen by evaluator.  *
+ *                     With EVALUATOR_NNUE accumulator has to       *
+ *                     belong to state, if it is NULL the           *
+ *                     accumulator is computed from scratch.        *
+ ********************************************************************/
+int evaluator_evaluate(const Evaluator *evaluator, const Game_state *state, const Nnue_accumulator *accumulator);
+
+#endif
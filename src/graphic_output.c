@@ -17,7 +17,40 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Offsets into a board written by write_current_board(): the file
+// labels of the top and the bottom line, the line of the rank shown
+// at the top, the lines of one rank, the piece of the first square
+// of a rank line and the distance between two squares, the rank
+// label on the right.
+#define BOARD_FILES_TOP 5
+#define BOARD_FILES_BOTTOM 1390
+#define BOARD_FIRST_RANK 157
+#define BOARD_RANK_STEP 160
+#define BOARD_SQUARE_OFFSET 5
+#define BOARD_SQUARE_STEP 6
+#define BOARD_RANK_RIGHT 52
+
+#define BOARD_TEMPLATE_RANK \
+    "  |     |     |     |     |     |     |     |     | \n" \
+    "  |     |     |     |     |     |     |     |     |  \n" \
+    "  |_____|_____|_____|_____|_____|_____|_____|_____| \n"
+
+// a board without labels and pieces
+PRIVATE const char board_template[] =
+    "                                                  \n"
+    "  _________________________________________________ \n"
+    BOARD_TEMPLATE_RANK BOARD_TEMPLATE_RANK BOARD_TEMPLATE_RANK BOARD_TEMPLATE_RANK
+    BOARD_TEMPLATE_RANK BOARD_TEMPLATE_RANK BOARD_TEMPLATE_RANK BOARD_TEMPLATE_RANK
+    "\n"
+    "                                                \n";
+
+_Static_assert(sizeof(board_template) == BOARD_TEXT_LENGTH + 1, "board_template does not match BOARD_TEXT_LENGTH");
+
 PRIVATE char intern_to_output_symbol(const Letter_piece intern);
+PRIVATE void board_write(char *text, Cell *cells, Game game, Color orientation);
+PRIVATE void board_update(char *text, Cell *cells, Game game, Color orientation);
+PRIVATE void board_write_square(char *text, Cell *cells, Game game, Color orientation, Square square);
+PRIVATE void board_put(char *text, Cell *cells, int offset, char character);
 
 /********************************************************************
  * intern_to_output_symbol: Uses one the symbols internally
@@ -98,53 +131,102 @@ void print_board(Game_state *game_state)
 }
 
 /********************************************************************
- * write_current_board: Writes the board of game into dest in the
- *                      way it should be displayed on the screen.
- *                      orientation, as the name suggests, gives the
- *                      orientation of the displayed board, which
- *                      either should be WHITE or BLACK.
- *                      If valid orientation is provided, it will
- *                      default to WHITE.
+ * write_current_board: Copies board_template and writes the labels
+ *                      and the pieces to their offsets.
  ********************************************************************/
 void write_current_board(char *dest, Game game, Color orientation)
 {
-    const Letter_piece *board = current_board(game);
-    *dest = '\0';
-    char buffer[1000];
+    board_write(dest, NULL, game, orientation);
+}
 
-    strncat(dest, " ", 1000);
-    int i, j;
-    for (i = 0; i <= 7; i++)
+void write_current_board_cells(Cell *dest, Game game, Color orientation)
+{
+    board_write(NULL, dest, game, orientation);
+}
+
+/********************************************************************
+ * update_current_board: Rewrites the squares of last_changes().
+ ********************************************************************/
+void update_current_board(char *dest, Game game, Color orientation)
+{
+    board_update(dest, NULL, game, orientation);
+}
+
+void update_current_board_cells(Cell *dest, Game game, Color orientation)
+{
+    board_update(NULL, dest, game, orientation);
+}
+
+/********************************************************************
+ * board_write: Writes the whole board to text or, if text is NULL,
+ *              to cells.
+ ********************************************************************/
+PRIVATE void board_write(char *text, Cell *cells, Game game, Color orientation)
+{
+    if (NULL != text)
+        memcpy(text, board_template, sizeof(board_template));
+    else
     {
-        sprintf(buffer, "    %c ", (BLACK == orientation) ? ('h' - i) : ('a' + i));
-        strncat(dest, buffer, 1000);
+        // the '\0' of the template becomes the cell ending the content
+        for (size_t i = 0; i < sizeof(board_template); i++)
+            cells[i] = (Cell) {(unsigned char) board_template[i], 0};
     }
 
-    sprintf(buffer, " \n  _________________________________________________ \n");
-    strncat(dest,buffer, 1000);
-    for (i = 0; i <= 7; i++)
+    for (int i = 0; i < BOARD_COLUMNS; i++)
     {
-        sprintf(buffer, "  |     |     |     |     |     |     |     |     | \n%d |",
-                (BLACK == orientation) ? (i + 1) : (8 - i));
-        strncat(dest, buffer, 1000);
-
-        for (j = 0; j <= 7; j++)
-        {
-            sprintf(buffer, "  %c  |",
-                    intern_to_output_symbol(*(board + ((BLACK == orientation) ? ((7-i)*8+j) : (8*i+j)))));
-            strncat(dest, buffer, 1000);
-        }
-
-        sprintf(buffer, " %d\n  |_____|_____|_____|_____|_____|_____|_____|_____| \n",
-                (BLACK == orientation) ? (i + 1) : (8 - i));
-        strncat(dest, buffer, 1000);
+        char file = (BLACK == orientation) ? ('h' - i) : ('a' + i);
+        board_put(text, cells, BOARD_FILES_TOP + i * BOARD_SQUARE_STEP, file);
+        board_put(text, cells, BOARD_FILES_BOTTOM + i * BOARD_SQUARE_STEP, file);
+    }
+    for (int i = 0; i < BOARD_ROWS; i++)
+    {
+        char rank = (BLACK == orientation) ? ('1' + i) : ('8' - i);
+        board_put(text, cells, BOARD_FIRST_RANK + i * BOARD_RANK_STEP, rank);
+        board_put(text, cells, BOARD_FIRST_RANK + i * BOARD_RANK_STEP + BOARD_RANK_RIGHT, rank);
     }
 
-    strncat(dest, "\n", 1000);
-    for (i = 0; i <= 7; i++)
+    for (int row = 0; row < BOARD_ROWS; row++)
     {
-        sprintf(buffer, "     %c", (BLACK == orientation) ? ('h' - i) : ('a' + i));
-        strncat(dest, buffer, 1000);
+        for (int column = 0; column < BOARD_COLUMNS; column++)
+            board_write_square(text, cells, game, orientation, (Square) {row, column});
     }
-    strncat(dest, "\n", 1000);
+}
+
+/********************************************************************
+ * board_update: Writes the squares changed by the last move to text
+ *               or, if text is NULL, to cells.
+ ********************************************************************/
+PRIVATE void board_update(char *text, Cell *cells, Game game, Color orientation)
+{
+    Square squares[GAME_STATE_CHANGES];
+    int number = last_changes(game, squares);
+    if (0 > number)
+    {
+        board_write(text, cells, game, orientation);
+        return;
+    }
+
+    for (int i = 0; i < number; i++)
+        board_write_square(text, cells, game, orientation, squares[i]);
+}
+
+/********************************************************************
+ * board_write_square: Writes the piece on square to its offset.
+ *                     With orientation BLACK, the first rank and the
+ *                     h-file are shown at the top left.
+ ********************************************************************/
+PRIVATE void board_write_square(char *text, Cell *cells, Game game, Color orientation, Square square)
+{
+    int line = (BLACK == orientation) ? square.row : BOARD_ROWS - 1 - square.row;
+    int column = (BLACK == orientation) ? BOARD_COLUMNS - 1 - square.column : square.column;
+    board_put(text, cells, BOARD_FIRST_RANK + line * BOARD_RANK_STEP + BOARD_SQUARE_OFFSET + column * BOARD_SQUARE_STEP,
+              intern_to_output_symbol(piece_at(game, square)));
+}
+
+PRIVATE void board_put(char *text, Cell *cells, int offset, char character)
+{
+    if (NULL != text)
+        text[offset] = character;
+    else
+        cells[offset] = (Cell) {(unsigned char) character, 0};
 }
@@ -5,6 +5,12 @@
 #define GRAPHIC_OUTPUT_H
 
 #include "core_functions.h"
+#include "core_interface.h"
+#include "tui_lib.h"
+
+// number of characters of a board written by write_current_board()
+// without the '\0' (30 lines)
+#define BOARD_TEXT_LENGTH 1434
 
 /********************************************************************
  * piece_to_letter: Returns the letter associated with a piece.     *
@@ -22,11 +28,37 @@ void print_board(Game_state *game_state);
  *                      orientation, as the name suggests, gives the
  *                      orientation of the displayed board, which
  *                      either should be WHITE or BLACK.
- *                      If valid orientation is provided, it will
+ *                      If no valid orientation is provided, it will
  *                      default to WHITE.
+ *                      dest has to hold BOARD_TEXT_LENGTH + 1
+ *                      characters, the last one is '\0'.
  ********************************************************************/
 void write_current_board(char *dest, Game game, Color orientation);
 
+/********************************************************************
+ * write_current_board_cells: Same as write_current_board(), but
+ *                            writes BOARD_TEXT_LENGTH + 1 cells of
+ *                            style 0 for window_update_cells(), the
+ *                            last one of code point 0.
+ ********************************************************************/
+void write_current_board_cells(Cell *dest, Game game, Color orientation);
+
+/********************************************************************
+ * update_current_board: dest has to hold the board written with
+ *                       orientation for the position before the
+ *                       last move of game. Rewrites only the squares
+ *                       changed by the last move, or the whole board
+ *                       if they are not known (see last_changes()).
+ ********************************************************************/
+void update_current_board(char *dest, Game game, Color orientation);
+
+/********************************************************************
+ * update_current_board_cells: Same as update_current_board() for
+ *                             cells written by
+ *                             write_current_board_cells().
+ ********************************************************************/
+void update_current_board_cells(Cell *dest, Game game, Color orientation);
+
 /********************************************************************
  * display_game_screen: Displays the games main screen.
  ********************************************************************/
@@ -14,38 +14,174 @@
 
 #include "core_interface.h"
 #include "graphic_output.h"
+#include "input.h"
 #include "mem_utilities.h"
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
 
-// initial size of dynamically allocated the string used for saving input (see: read_input())
-#define INITIAL_INPUT_SIZE 16
+// number of bytes requested from the file descriptor with each read()
+#define INPUT_BLOCK_SIZE 65536
+
+// typedef in input.h
+struct input_reader {
+    int fd;
+    char *buffer;
+    int capacity;
+    // unread data is buffer[begin] to buffer[end - 1]
+    int begin;
+    int end;
+    // buffer[begin] to buffer[scanned - 1] is known to contain no '\n'
+    int scanned;
+    bool eof;
+};
+
+PRIVATE bool input_reader_fill(Input_reader reader);
+
+// used by read_input()
+PRIVATE Input_reader stdin_reader = NULL;
 
 /////////////////////////////////////////////////////////////////////
-// read_input: starts with INITIAL_INPUT_SIZE * sizeof(char)
-//             memory allocated for saving the input.
-//             Whenever the input starts exceeding the allocated
-//             space, memory is doubled.
+// input_reader_create: The buffer starts with one block (and one
+//                      additional byte, so that there always is
+//                      room to terminate the last line).
 /////////////////////////////////////////////////////////////////////
-char *read_input(void)
+Input_reader input_reader_create(int fd)
 {
-    char *input = malloc(INITIAL_INPUT_SIZE * sizeof(*input));
-    MEM_TEST(input);
-    int current_size = INITIAL_INPUT_SIZE;
-    int count = 0;
-    char c;
-    while (('\n' != (c = getchar())) && (EOF != c))
+    Input_reader new_reader = mem_alloc(MEM_GENERAL, sizeof(*new_reader));
+
+    new_reader->fd = fd;
+    new_reader->capacity = INPUT_BLOCK_SIZE + 1;
+    new_reader->buffer = mem_alloc(MEM_GENERAL, new_reader->capacity * sizeof(*new_reader->buffer));
+    new_reader->begin = 0;
+    new_reader->end = 0;
+    new_reader->scanned = 0;
+    new_reader->eof = false;
+
+    return new_reader;
+}
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_destroy: Destroys reader. Does not close its file
+//                       descriptor.
+/////////////////////////////////////////////////////////////////////
+void input_reader_destroy(Input_reader reader)
+{
+    mem_free(MEM_GENERAL, reader->buffer, reader->capacity * sizeof(*reader->buffer));
+    mem_free(MEM_GENERAL, reader, sizeof(*reader));
+}
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_next_line: Lines are split in place, by overwriting
+//                         the '\n' with '\0'. Only if no complete
+//                         line is left in the buffer, more data is
+//                         read.
+/////////////////////////////////////////////////////////////////////
+bool input_reader_next_line(Input_reader reader, Input_line *line)
+{
+    char *newline;
+    while (NULL == (newline = memchr(reader->buffer + reader->scanned, '\n', reader->end - reader->scanned)))
     {
-        if (count >= current_size - 2)
+        reader->scanned = reader->end;
+        if (reader->eof || !input_reader_fill(reader))
         {
-            input = realloc(input, 2*current_size);
-            MEM_TEST(input);
-            current_size *= 2;
+            reader->eof = true;
+            break;
         }
-        *(input + count++) = c;
     }
+
+    int line_begin = reader->begin;
+    int line_end;
+    if (NULL != newline)
+    {
+        line_end = newline - reader->buffer;
+        reader->begin = line_end + 1;
+    }
+    else
+    {
+        // last line without '\n'
+        if (reader->begin == reader->end)
+            return false;
+        line_end = reader->end;
+        reader->begin = reader->end;
+    }
+    reader->scanned = reader->begin;
+
+    if ((line_end > line_begin) && ('\r' == reader->buffer[line_end - 1]))
+        line_end--;
+    reader->buffer[line_end] = '\0';
+
+    line->text = reader->buffer + line_begin;
+    line->length = line_end - line_begin;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_eof: Returns true if the end of the input has been
+//                   reached and all lines have been handed out.
+/////////////////////////////////////////////////////////////////////
+bool input_reader_eof(Input_reader reader)
+{
+    return reader->eof && (reader->begin == reader->end);
+}
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_fill: Moves the unread data to the beginning of the
+//                    buffer, then reads another block behind it.
+//                    The buffer only grows, if a single line does
+//                    not fit into it.
+//                    Returns false on end of input or read error.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool input_reader_fill(Input_reader reader)
+{
+    if (reader->begin > 0)
+    {
+        memmove(reader->buffer, reader->buffer + reader->begin, reader->end - reader->begin);
+        reader->end -= reader->begin;
+        reader->scanned -= reader->begin;
+        reader->begin = 0;
+    }
+
+    // one byte stays free for terminating the last line
+    if (reader->capacity - 1 == reader->end)
+    {
+        int capacity = 2 * reader->capacity - 1;
+        reader->buffer = mem_realloc(MEM_GENERAL, reader->buffer, reader->capacity * sizeof(*reader->buffer),
+                                     capacity * sizeof(*reader->buffer));
+        reader->capacity = capacity;
+    }
+
+    ssize_t count;
+    do
+        count = read(reader->fd, reader->buffer + reader->end, reader->capacity - 1 - reader->end);
+    while ((count < 0) && (EINTR == errno));
+
+    if (count <= 0)
+        return false;
+    reader->end += count;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+// read_input: Reads the next line with a reader on stdin, which
+//             lives as long as the program, and returns a copy of
+//             it.
+/////////////////////////////////////////////////////////////////////
+char *read_input(void)
+{
+    if (NULL == stdin_reader)
+        stdin_reader = input_reader_create(STDIN_FILENO);
+
+    Input_line line = { "", 0 };
+    input_reader_next_line(stdin_reader, &line);
+
+    char *input = malloc((line.length + 1) * sizeof(*input));
+    MEM_TEST(input);
+    memcpy(input, line.text, line.length + 1);
+
     // make sure, that ending input with EOF and '\n' has the same effect on the terminal
-    if (EOF == c)
+    if (input_reader_eof(stdin_reader))
         putchar('\n');
-    *(input + count) = '\0';
     return input;
 }
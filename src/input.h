@@ -14,12 +14,58 @@
 #include "core_interface.h"
 #include <stdbool.h>
 
+typedef struct input_reader *Input_reader;
+
+/////////////////////////////////////////////////////////////////////
+// Input_line: A line handed out by input_reader_next_line().
+//             text points into the reader's buffer and is '\0'
+//             terminated. It stays valid until the next call to
+//             input_reader_next_line() or input_reader_destroy().
+//             length does not include the line terminator.
+/////////////////////////////////////////////////////////////////////
+typedef struct input_line {
+    const char *text;
+    int length;
+} Input_line;
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_create: Creates a reader for the file descriptor fd.
+//                      The reader reads in large blocks and reuses
+//                      its buffer for all lines, so that reading
+//                      a line normally does not allocate memory.
+/////////////////////////////////////////////////////////////////////
+Input_reader input_reader_create(int fd);
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_destroy: Destroys reader. Does not close its file
+//                       descriptor.
+/////////////////////////////////////////////////////////////////////
+void input_reader_destroy(Input_reader reader);
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_next_line: Writes the next line to *line.
+//                         Lines can be terminated by "\n", "\r\n"
+//                         or the end of the input.
+//                         Returns false if there are no more lines
+//                         (end of input or read error).
+/////////////////////////////////////////////////////////////////////
+bool input_reader_next_line(Input_reader reader, Input_line *line);
+
+/////////////////////////////////////////////////////////////////////
+// input_reader_eof: Returns true if the end of the input has been
+//                   reached and all lines have been handed out.
+/////////////////////////////////////////////////////////////////////
+bool input_reader_eof(Input_reader reader);
+
 /////////////////////////////////////////////////////////////////////
 // read_input: reads a line of text from stdin which can be
 //             terminated by either '\n' or EOF.
+//             Uses an Input_reader on stdin internally, so it should
+//             not be mixed with other ways of reading stdin.
 //             Returns a dynamically allocated '\0' terminated string.
 //             It is the callers responsibillity to disallocate the
-//             memory, when the sting is not needed anymore.
+//             memory with free(), when the sting is not needed
+//             anymore.
 //             Behavior is undefined if string is not '\0'
 //             terminated.
 /////////////////////////////////////////////////////////////////////
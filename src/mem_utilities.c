@@ -0,0 +1,536 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+#define PRIVATE static
+
+#include "mem_utilities.h"
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// names of the subsystems in mem_dump()
+PRIVATE const char *mem_subsystem_names[MEM_SUBSYSTEMS] = {
+    [MEM_GENERAL] = "general",
+    [MEM_GAME_STATE] = "game_state",
+    [MEM_TUI] = "tui",
+    [MEM_POOL] = "pool",
+    [MEM_EVALUATION] = "evaluation",
+    [MEM_BOOK] = "book",
+    [MEM_BITBASE] = "bitbase",
+};
+
+// counters of one subsystem, see Mem_statistics
+typedef struct mem_counters {
+    atomic_long allocations;
+    atomic_long reallocations;
+    atomic_long frees;
+    atomic_long bytes_live;
+    atomic_long bytes_peak;
+    atomic_long bytes_total;
+} Mem_counters;
+
+PRIVATE Mem_counters mem_counters[MEM_SUBSYSTEMS];
+PRIVATE const Mem_backend *mem_backend = NULL;     // NULL: malloc(), realloc() and free()
+PRIVATE atomic_llong mem_start = 0;                // in ns, set by the first allocation or mem_statistics_reset()
+
+PRIVATE void *mem_backend_alloc(size_t size);
+PRIVATE void mem_count(Mem_subsystem subsystem, long bytes);
+PRIVATE void mem_fail(const char *function, size_t size);
+PRIVATE long long mem_clock(void);
+
+// objects and slabs are aligned for any type
+#define POOL_ALIGN(size) (((size) + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t))
+
+// head of every slab, the objects follow
+typedef struct pool_slab {
+    struct pool_slab *next;
+    size_t size;                // in bytes, with the head
+} Pool_slab;
+
+// a freed object starts with the link of the free list
+typedef struct pool_free_object {
+    struct pool_free_object *next;
+} Pool_free_object;
+
+// typedef in mem_utilities.h
+struct pool {
+    size_t object_size;
+    int flags;
+    pthread_mutex_t mutex;      // POOL_THREADS only
+    pthread_key_t key;          // POOL_THREADS only, the Pool_cache of a thread
+    struct pool_cache *caches;  // POOL_THREADS only, the caches of all threads
+    Pool_slab *slabs;
+    int slab_objects;           // objects of the next slab
+    Pool_free_object *free_list;
+    long used;
+    long capacity;
+};
+
+// freed objects of one pool, kept by one thread
+typedef struct pool_cache {
+    Pool pool;
+    struct pool_cache *next;    // in pool->caches
+    int number;
+    void *objects[POOL_CACHE_SIZE];
+} Pool_cache;
+
+PRIVATE void *pool_take(Pool pool);
+PRIVATE void pool_give(Pool pool, void *object);
+PRIVATE void pool_grow(Pool pool);
+PRIVATE Pool_cache *pool_cache(Pool pool);
+PRIVATE void pool_cache_release(void *cache);
+PRIVATE void pool_check_poison(Pool pool, const unsigned char *object);
+
+/********************************************************************
+ * mem_alloc: Aborts through mem_fail() if mem_try_alloc() fails.
+ ********************************************************************/
+void *mem_alloc(Mem_subsystem subsystem, size_t size)
+{
+    void *pointer = mem_try_alloc(subsystem, size);
+    if ((NULL == pointer) && (0 < size))
+        mem_fail(__func__, size);
+    return pointer;
+}
+
+/********************************************************************
+ * mem_calloc: The default backend uses calloc(), others get the
+ *             memory set to 0 by memset().
+ ********************************************************************/
+void *mem_calloc(Mem_subsystem subsystem, size_t number, size_t size)
+{
+    if ((0 < size) && (number > SIZE_MAX / size))
+        mem_fail(__func__, SIZE_MAX);
+
+    void *pointer;
+    if (NULL == mem_backend)
+        pointer = calloc(number, size);
+    else if (NULL != (pointer = mem_backend_alloc(number * size)))
+        memset(pointer, 0, number * size);
+    if ((NULL == pointer) && (0 < number * size))
+        mem_fail(__func__, number * size);
+
+    atomic_fetch_add_explicit(&mem_counters[subsystem].allocations, 1, memory_order_relaxed);
+    mem_count(subsystem, number * size);
+    return pointer;
+}
+
+/********************************************************************
+ * mem_try_alloc: Nothing is counted on failure.
+ ********************************************************************/
+void *mem_try_alloc(Mem_subsystem subsystem, size_t size)
+{
+    void *pointer = mem_backend_alloc(size);
+    if ((NULL == pointer) && (0 < size))
+        return NULL;
+
+    atomic_fetch_add_explicit(&mem_counters[subsystem].allocations, 1, memory_order_relaxed);
+    mem_count(subsystem, size);
+    return pointer;
+}
+
+/********************************************************************
+ * mem_realloc: Resizing NULL counts as an allocation, resizing to 0
+ *              bytes frees pointer and returns NULL.
+ ********************************************************************/
+void *mem_realloc(Mem_subsystem subsystem, void *pointer, size_t old_size, size_t size)
+{
+    if (NULL == pointer)
+        return mem_alloc(subsystem, size);
+    if (0 == size)
+    {
+        mem_free(subsystem, pointer, old_size);
+        return NULL;
+    }
+
+    void *new_pointer = (NULL == mem_backend) ? realloc(pointer, size)
+                                              : mem_backend->realloc(mem_backend->context, pointer, old_size, size);
+    if (NULL == new_pointer)
+        mem_fail(__func__, size);
+
+    atomic_fetch_add_explicit(&mem_counters[subsystem].reallocations, 1, memory_order_relaxed);
+    mem_count(subsystem, (long) size - (long) old_size);
+    return new_pointer;
+}
+
+/********************************************************************
+ * mem_free: Only counts pointers other than NULL.
+ ********************************************************************/
+void mem_free(Mem_subsystem subsystem, void *pointer, size_t size)
+{
+    if (NULL == pointer)
+        return;
+
+    if (NULL == mem_backend)
+        free(pointer);
+    else
+        mem_backend->free(mem_backend->context, pointer, size);
+
+    atomic_fetch_add_explicit(&mem_counters[subsystem].frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&mem_counters[subsystem].bytes_live, (long) size, memory_order_relaxed);
+}
+
+/********************************************************************
+ * mem_set_backend: The caller keeps backend alive while it is set.
+ ********************************************************************/
+void mem_set_backend(const Mem_backend *backend)
+{
+    mem_backend = backend;
+}
+
+/********************************************************************
+ * mem_statistics: The counters are read one by one, so they can be
+ *                 slightly apart while other threads allocate.
+ ********************************************************************/
+void mem_statistics(Mem_subsystem subsystem, Mem_statistics *statistics)
+{
+    Mem_counters *counters = &mem_counters[subsystem];
+    statistics->allocations = atomic_load_explicit(&counters->allocations, memory_order_relaxed);
+    statistics->reallocations = atomic_load_explicit(&counters->reallocations, memory_order_relaxed);
+    statistics->frees = atomic_load_explicit(&counters->frees, memory_order_relaxed);
+    statistics->bytes_live = atomic_load_explicit(&counters->bytes_live, memory_order_relaxed);
+    statistics->bytes_peak = atomic_load_explicit(&counters->bytes_peak, memory_order_relaxed);
+    statistics->bytes_total = atomic_load_explicit(&counters->bytes_total, memory_order_relaxed);
+}
+
+/********************************************************************
+ * mem_statistics_reset: Not atomic as a whole, other threads should not
+ *                       allocate meanwhile.
+ ********************************************************************/
+void mem_statistics_reset(void)
+{
+    for (int i = 0; i < MEM_SUBSYSTEMS; i++)
+    {
+        Mem_counters *counters = &mem_counters[i];
+        atomic_store(&counters->allocations, 0);
+        atomic_store(&counters->reallocations, 0);
+        atomic_store(&counters->frees, 0);
+        atomic_store(&counters->bytes_peak, atomic_load(&counters->bytes_live));
+        atomic_store(&counters->bytes_total, 0);
+    }
+    atomic_store(&mem_start, mem_clock());
+}
+
+/********************************************************************
+ * mem_dump: The rates are taken over the time since the first
+ *           allocation or the last mem_statistics_reset().
+ ********************************************************************/
+void mem_dump(FILE *stream)
+{
+    long long start = atomic_load(&mem_start);
+    double seconds = (0 == start) ? 0 : (mem_clock() - start) / 1e9;
+
+    fprintf(stream, "%-12s %12s %12s %12s %12s %12s %12s %14s\n", "subsystem",
+            "live", "peak", "total", "allocations", "reallocs", "frees", "allocations/s");
+    for (int i = 0; i < MEM_SUBSYSTEMS; i++)
+    {
+        Mem_statistics statistics;
+        mem_statistics(i, &statistics);
+        fprintf(stream, "%-12s %12ld %12ld %12ld %12ld %12ld %12ld %14.1f\n", mem_subsystem_names[i],
+                statistics.bytes_live, statistics.bytes_peak, statistics.bytes_total,
+                statistics.allocations, statistics.reallocations, statistics.frees,
+                (0 < seconds) ? (statistics.allocations + statistics.reallocations) / seconds : 0.0);
+    }
+}
+
+/********************************************************************
+ * pool_create: Rounds object_size up, so a freed object can hold
+ *              the link of the free list and the next object is
+ *              aligned.
+ ********************************************************************/
+Pool pool_create(size_t object_size, int flags)
+{
+    Pool pool = mem_alloc(MEM_POOL, sizeof(*pool));
+    pool->object_size = POOL_ALIGN((object_size < sizeof(Pool_free_object)) ? sizeof(Pool_free_object) : object_size);
+    pool->flags = flags;
+    pool->caches = NULL;
+    if (flags & POOL_THREADS)
+    {
+        pthread_mutex_init(&pool->mutex, NULL);
+        if (0 != pthread_key_create(&pool->key, pool_cache_release))
+        {
+            fprintf(stderr, "error: %s: no thread-specific key left; aborting\n", __func__);
+            exit(EXIT_FAILURE);
+        }
+    }
+    pool->slabs = NULL;
+    pool->slab_objects = POOL_MIN_SLAB;
+    pool->free_list = NULL;
+    pool->used = 0;
+    pool->capacity = 0;
+    return pool;
+}
+
+/********************************************************************
+ * pool_destroy: Objects still in thread caches are dropped with
+ *               their slabs. Deleting the key keeps threads exiting
+ *               later from releasing their caches.
+ ********************************************************************/
+void pool_destroy(Pool pool)
+{
+    if (pool->flags & POOL_THREADS)
+    {
+        pthread_key_delete(pool->key);
+        while (NULL != pool->caches)
+        {
+            Pool_cache *next = pool->caches->next;
+            mem_free(MEM_POOL, pool->caches, sizeof(*pool->caches));
+            pool->caches = next;
+        }
+    }
+
+    Pool_slab *slab = pool->slabs;
+    while (NULL != slab)
+    {
+        Pool_slab *next = slab->next;
+        mem_free(MEM_POOL, slab, slab->size);
+        slab = next;
+    }
+    if (pool->flags & POOL_THREADS)
+        pthread_mutex_destroy(&pool->mutex);
+    mem_free(MEM_POOL, pool, sizeof(*pool));
+}
+
+/********************************************************************
+ * pool_alloc: With POOL_THREADS the thread's cache is used first.
+ *             An empty cache is refilled with half of its size
+ *             under one lock.
+ ********************************************************************/
+void *pool_alloc(Pool pool)
+{
+    void *object;
+    if (pool->flags & POOL_THREADS)
+    {
+        Pool_cache *cache = pool_cache(pool);
+        if (0 == cache->number)
+        {
+            pthread_mutex_lock(&pool->mutex);
+            while (cache->number < POOL_CACHE_SIZE / 2)
+                cache->objects[cache->number++] = pool_take(pool);
+            pthread_mutex_unlock(&pool->mutex);
+        }
+        object = cache->objects[--cache->number];
+    }
+    else
+        object = pool_take(pool);
+
+    if (pool->flags & POOL_POISON)
+    {
+        pool_check_poison(pool, object);
+        memset(object, POOL_FRESH_BYTE, pool->object_size);
+    }
+    return object;
+}
+
+/********************************************************************
+ * pool_free: With POOL_THREADS a full cache gives half of its
+ *            objects back under one lock.
+ ********************************************************************/
+void pool_free(Pool pool, void *object)
+{
+    if (NULL == object)
+        return;
+
+    if (pool->flags & POOL_POISON)
+        memset(object, POOL_POISON_BYTE, pool->object_size);
+
+    if (pool->flags & POOL_THREADS)
+    {
+        Pool_cache *cache = pool_cache(pool);
+        if (POOL_CACHE_SIZE == cache->number)
+        {
+            pthread_mutex_lock(&pool->mutex);
+            while (cache->number > POOL_CACHE_SIZE / 2)
+                pool_give(pool, cache->objects[--cache->number]);
+            pthread_mutex_unlock(&pool->mutex);
+        }
+        cache->objects[cache->number++] = object;
+    }
+    else
+        pool_give(pool, object);
+}
+
+/********************************************************************
+ * pool_statistics: Reads the counters under the lock.
+ ********************************************************************/
+void pool_statistics(Pool pool, long *used, long *capacity)
+{
+    if (pool->flags & POOL_THREADS)
+        pthread_mutex_lock(&pool->mutex);
+    *used = pool->used;
+    *capacity = pool->capacity;
+    if (pool->flags & POOL_THREADS)
+        pthread_mutex_unlock(&pool->mutex);
+}
+
+/********************************************************************
+ * pool_take: Takes an object from the free list, growing the pool
+ *            if it is empty. The caller holds the lock.
+ ********************************************************************/
+PRIVATE void *pool_take(Pool pool)
+{
+    if (NULL == pool->free_list)
+        pool_grow(pool);
+
+    Pool_free_object *object = pool->free_list;
+    pool->free_list = object->next;
+    pool->used++;
+    return object;
+}
+
+/********************************************************************
+ * pool_give: Puts object onto the free list. The caller holds the
+ *            lock.
+ ********************************************************************/
+PRIVATE void pool_give(Pool pool, void *object)
+{
+    Pool_free_object *free_object = object;
+    free_object->next = pool->free_list;
+    pool->free_list = free_object;
+    pool->used--;
+}
+
+/********************************************************************
+ * pool_grow: Adds a slab and puts its objects onto the free list,
+ *            the first one on top.
+ ********************************************************************/
+PRIVATE void pool_grow(Pool pool)
+{
+    size_t head = POOL_ALIGN(sizeof(Pool_slab));
+    size_t size = head + pool->slab_objects * pool->object_size;
+    Pool_slab *slab = mem_alloc(MEM_POOL, size);
+    slab->next = pool->slabs;
+    slab->size = size;
+    pool->slabs = slab;
+
+    unsigned char *objects = (unsigned char *) slab + head;
+    if (pool->flags & POOL_POISON)
+        memset(objects, POOL_POISON_BYTE, pool->slab_objects * pool->object_size);
+    for (int i = pool->slab_objects - 1; i >= 0; i--)
+    {
+        Pool_free_object *object = (Pool_free_object *) (objects + i * pool->object_size);
+        object->next = pool->free_list;
+        pool->free_list = object;
+    }
+
+    pool->capacity += pool->slab_objects;
+    if (pool->slab_objects < POOL_MAX_SLAB)
+        pool->slab_objects *= 2;
+}
+
+/********************************************************************
+ * pool_cache: Returns the cache of the calling thread for pool,
+ *             creating it on the first call of the thread.
+ ********************************************************************/
+PRIVATE Pool_cache *pool_cache(Pool pool)
+{
+    Pool_cache *cache = pthread_getspecific(pool->key);
+    if (NULL != cache)
+        return cache;
+
+    cache = mem_alloc(MEM_POOL, sizeof(*cache));
+    cache->pool = pool;
+    cache->number = 0;
+    pthread_mutex_lock(&pool->mutex);
+    cache->next = pool->caches;
+    pool->caches = cache;
+    pthread_mutex_unlock(&pool->mutex);
+    pthread_setspecific(pool->key, cache);
+    return cache;
+}
+
+/********************************************************************
+ * pool_cache_release: Called when a thread exits. Gives the objects
+ *                     of the thread's cache back to its pool and
+ *                     frees the cache.
+ ********************************************************************/
+PRIVATE void pool_cache_release(void *cache)
+{
+    Pool_cache *released = cache;
+    Pool pool = released->pool;
+    pthread_mutex_lock(&pool->mutex);
+    while (0 < released->number)
+        pool_give(pool, released->objects[--released->number]);
+    Pool_cache **link = &pool->caches;
+    while (released != *link)
+        link = &(*link)->next;
+    *link = released->next;
+    pthread_mutex_unlock(&pool->mutex);
+    mem_free(MEM_POOL, released, sizeof(*released));
+}
+
+/********************************************************************
+ * pool_check_poison: Aborts the program if a byte of object, other
+ *                    than the link of the free list, is no longer
+ *                    POOL_POISON_BYTE.
+ ********************************************************************/
+PRIVATE void pool_check_poison(Pool pool, const unsigned char *object)
+{
+    for (size_t i = sizeof(Pool_free_object); i < pool->object_size; i++)
+    {
+        if (POOL_POISON_BYTE != object[i])
+        {
+            fprintf(stderr, "error: %s: object %p was written to after pool_free(); aborting\n",
+                    __func__, (const void *) object);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/********************************************************************
+ * mem_backend_alloc: Allocates size bytes from the current backend.
+ ********************************************************************/
+PRIVATE void *mem_backend_alloc(size_t size)
+{
+    if (NULL == mem_backend)
+        return malloc(size);
+    return mem_backend->alloc(mem_backend->context, size);
+}
+
+/********************************************************************
+ * mem_count: Adds bytes (negative when shrinking) to the bytes live
+ *            of subsystem and raises its peak. Starts the clock of
+ *            mem_dump() on the first call.
+ ********************************************************************/
+PRIVATE void mem_count(Mem_subsystem subsystem, long bytes)
+{
+    Mem_counters *counters = &mem_counters[subsystem];
+    long live = atomic_fetch_add_explicit(&counters->bytes_live, bytes, memory_order_relaxed) + bytes;
+    if (0 < bytes)
+        atomic_fetch_add_explicit(&counters->bytes_total, bytes, memory_order_relaxed);
+
+    long peak = atomic_load_explicit(&counters->bytes_peak, memory_order_relaxed);
+    while ((live > peak)
+        && !atomic_compare_exchange_weak_explicit(&counters->bytes_peak, &peak, live,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+
+    if (0 == atomic_load_explicit(&mem_start, memory_order_relaxed))
+    {
+        long long expected = 0;
+        atomic_compare_exchange_strong(&mem_start, &expected, mem_clock());
+    }
+}
+
+/********************************************************************
+ * mem_fail: Aborts the program like MEM_TEST.
+ ********************************************************************/
+PRIVATE void mem_fail(const char *function, size_t size)
+{
+    fprintf(stderr, "error: %s: memory-allocation of %zu bytes failed; aborting\n", function, size);
+    exit(EXIT_FAILURE);
+}
+
+/********************************************************************
+ * mem_clock: Returns the monotonic time in ns.
+ ********************************************************************/
+PRIVATE long long mem_clock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
@@ -4,6 +4,7 @@
 #ifndef MEM_UTILITIES_H
 #define MEM_UTILITIES_H
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -20,4 +21,170 @@
     } \
 }
 
+/********************************************************************
+ * Allocation layer: Every allocation is attributed to a subsystem,
+ *                   which counts allocations, frees and the bytes
+ *                   live, at their peak and in total.
+ *                   Sizes are passed to mem_free() and
+ *                   mem_realloc() as well, so no header is stored
+ *                   in front of the blocks.
+ *                   The counters are atomic, the functions can be
+ *                   called from several threads at once.
+ *                   Failed allocations abort the program like
+ *                   MEM_TEST, except for mem_try_alloc().
+ ********************************************************************/
+typedef enum mem_subsystem {
+    MEM_GENERAL,
+    MEM_GAME_STATE,     // Games and their history of Game_states
+    MEM_TUI,            // windows, screens, their buffers and renderers
+    MEM_POOL,           // slabs of Pools
+    MEM_EVALUATION,     // pawn tables, eval caches and networks
+    MEM_BOOK,
+    MEM_BITBASE,
+    MEM_SUBSYSTEMS,     // number of subsystems
+} Mem_subsystem;
+
+typedef struct mem_statistics {
+    long allocations;
+    long reallocations;
+    long frees;
+    long bytes_live;
+    long bytes_peak;
+    long bytes_total;   // all bytes ever allocated (growing reallocations count the difference)
+} Mem_statistics;
+
+/********************************************************************
+ * Mem_backend: Where the memory comes from. Blocks have to be
+ *              freed with the backend they were allocated with, so
+ *              a backend should be set before the first allocation
+ *              (or for a part of a test, which frees everything it
+ *              allocated). context is passed to all three
+ *              functions. alloc and realloc return NULL on failure.
+ ********************************************************************/
+typedef struct mem_backend {
+    void *(*alloc)(void *context, size_t size);
+    void *(*realloc)(void *context, void *pointer, size_t old_size, size_t size);
+    void (*free)(void *context, void *pointer, size_t size);
+    void *context;
+} Mem_backend;
+
+/********************************************************************
+ * mem_alloc: Allocates size bytes for subsystem.
+ ********************************************************************/
+void *mem_alloc(Mem_subsystem subsystem, size_t size);
+
+/********************************************************************
+ * mem_calloc: Allocates number * size bytes set to 0 for subsystem.
+ ********************************************************************/
+void *mem_calloc(Mem_subsystem subsystem, size_t number, size_t size);
+
+/********************************************************************
+ * mem_try_alloc: Same as mem_alloc(), but returns NULL on failure.
+ ********************************************************************/
+void *mem_try_alloc(Mem_subsystem subsystem, size_t size);
+
+/********************************************************************
+ * mem_realloc: Resizes pointer (NULL or a block of old_size bytes)
+ *              to size bytes.
+ ********************************************************************/
+void *mem_realloc(Mem_subsystem subsystem, void *pointer, size_t old_size, size_t size);
+
+/********************************************************************
+ * mem_free: Frees pointer (NULL or a block of size bytes).
+ ********************************************************************/
+void mem_free(Mem_subsystem subsystem, void *pointer, size_t size);
+
+/********************************************************************
+ * mem_set_backend: Makes all following allocations use backend.
+ *                  NULL sets malloc(), realloc() and free() again.
+ *                  Must not be called while other threads allocate.
+ ********************************************************************/
+void mem_set_backend(const Mem_backend *backend);
+
+/********************************************************************
+ * mem_statistics: Writes the counters of subsystem to *statistics.
+ ********************************************************************/
+void mem_statistics(Mem_subsystem subsystem, Mem_statistics *statistics);
+
+/********************************************************************
+ * mem_statistics_reset: Sets all counters but bytes_live to 0 and
+ *                       bytes_peak to bytes_live, and restarts the
+ *                       clock for the allocation rates of
+ *                       mem_dump().
+ ********************************************************************/
+void mem_statistics_reset(void);
+
+/********************************************************************
+ * mem_dump: Writes a table of the counters of all subsystems and
+ *           their allocations per second to stream.
+ ********************************************************************/
+void mem_dump(FILE *stream);
+
+/********************************************************************
+ * Pool: Allocator for objects of one fixed size.
+ *       Objects are cut from slabs, which hold POOL_MIN_SLAB
+ *       objects at first and twice as many as the slab before up
+ *       to POOL_MAX_SLAB objects. Freed objects go onto a free
+ *       list, so pool_alloc() and pool_free() take O(1) and slabs
+ *       are only returned to the system by pool_destroy().
+ *       Slabs are counted as MEM_POOL.
+ *
+ *       flags (can be combined with |):
+ *       POOL_THREADS: The pool can be used by several threads.
+ *                     Every thread keeps up to POOL_CACHE_SIZE
+ *                     freed objects of the pool in a cache of its
+ *                     own, the shared free list is locked only to
+ *                     move half a cache at once. A cache goes back
+ *                     to the pool when its thread exits.
+ *                     Every such pool takes a thread-specific key,
+ *                     of which there are at least
+ *                     _POSIX_THREAD_KEYS_MAX (128).
+ *       POOL_POISON:  Freed objects are filled with
+ *                     POOL_POISON_BYTE, pool_alloc() aborts the
+ *                     program if a freed object was written to.
+ *                     New objects are filled with POOL_FRESH_BYTE.
+ ********************************************************************/
+#define POOL_THREADS 1
+#define POOL_POISON 2
+
+#define POOL_MIN_SLAB 16
+#define POOL_MAX_SLAB 4096
+#define POOL_CACHE_SIZE 32
+#define POOL_POISON_BYTE 0xDB
+#define POOL_FRESH_BYTE 0xCD
+
+typedef struct pool *Pool;
+
+/********************************************************************
+ * pool_create: Creates a pool for objects of object_size bytes.
+ *              The objects are aligned for any type.
+ ********************************************************************/
+Pool pool_create(size_t object_size, int flags);
+
+/********************************************************************
+ * pool_destroy: Frees all objects of pool at once.
+ *               No thread may use pool anymore.
+ ********************************************************************/
+void pool_destroy(Pool pool);
+
+/********************************************************************
+ * pool_alloc: Returns an object of pool. Aborts the program if no
+ *             memory is left (see MEM_TEST).
+ ********************************************************************/
+void *pool_alloc(Pool pool);
+
+/********************************************************************
+ * pool_free: Gives object, which has to come from pool_alloc() of
+ *            the same pool, back to pool. NULL is ignored.
+ ********************************************************************/
+void pool_free(Pool pool, void *object);
+
+/********************************************************************
+ * pool_statistics: Writes the number of objects in use and the
+ *                  number of objects in all slabs. With
+ *                  POOL_THREADS, objects in thread caches count as
+ *                  used.
+ ********************************************************************/
+void pool_statistics(Pool pool, long *used, long *capacity);
+
 #endif
@@ -0,0 +1,284 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+#define PRIVATE static
+
+#include "nnue.h"
+#include "core_functions.h"
+#include "mem_utilities.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define NNUE_HEADER_SIZE 16
+#define NNUE_FILE_SIZE (NNUE_HEADER_SIZE + 2 * NNUE_FEATURES * NNUE_HIDDEN + 2 * NNUE_HIDDEN + 2 * NNUE_HIDDEN + 4)
+#define NNUE_CLIP 127
+
+struct nnue
+{
+    int16_t feature_weights[NNUE_FEATURES][NNUE_HIDDEN];
+    int16_t feature_biases[NNUE_HIDDEN];
+    int8_t output_weights[2 * NNUE_HIDDEN];
+    int32_t output_bias;
+};
+
+PRIVATE int feature_index(Piece_i piece, int row, int column, int perspective);
+PRIVATE void add_row(int16_t *values, const int16_t *row);
+PRIVATE void subtract_row(int16_t *values, const int16_t *row);
+PRIVATE int32_t output_sum(const int16_t *values, const int8_t *weights);
+PRIVATE uint32_t read_u32(const unsigned char *p);
+
+/********************************************************************
+ * nnue_load: The file is read at once and decoded byte by byte, so *
+ *            the host's endianness does not matter.                *
+ ********************************************************************/
+Nnue nnue_load(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (NULL == file)
+        return NULL;
+
+    unsigned char *buffer = mem_alloc(MEM_EVALUATION, NNUE_FILE_SIZE + 1);
+    // one byte more than expected, to detect files which are too long
+    size_t size = fread(buffer, 1, NNUE_FILE_SIZE + 1, file);
+    fclose(file);
+    if ((NNUE_FILE_SIZE != size)
+     || (0 != memcmp(buffer, "CHNN", 4))
+     || (NNUE_VERSION != read_u32(buffer + 4))
+     || (NNUE_FEATURES != read_u32(buffer + 8))
+     || (NNUE_HIDDEN != read_u32(buffer + 12)))
+    {
+        mem_free(MEM_EVALUATION, buffer, NNUE_FILE_SIZE + 1);
+        return NULL;
+    }
+
+    Nnue nnue = mem_alloc(MEM_EVALUATION, sizeof(*nnue));
+    const unsigned char *p = buffer + NNUE_HEADER_SIZE;
+    for (int i = 0; i < NNUE_FEATURES; i++)
+    {
+        for (int j = 0; j < NNUE_HIDDEN; j++, p += 2)
+            nnue->feature_weights[i][j] = (int16_t) (p[0] | (p[1] << 8));
+    }
+    for (int j = 0; j < NNUE_HIDDEN; j++, p += 2)
+        nnue->feature_biases[j] = (int16_t) (p[0] | (p[1] << 8));
+    for (int j = 0; j < 2 * NNUE_HIDDEN; j++, p++)
+        nnue->output_weights[j] = (int8_t) p[0];
+    nnue->output_bias = (int32_t) read_u32(p);
+
+    mem_free(MEM_EVALUATION, buffer, NNUE_FILE_SIZE + 1);
+    return nnue;
+}
+
+/********************************************************************
+ * nnue_destroy: Frees nnue.                                        *
+ ********************************************************************/
+void nnue_destroy(Nnue nnue)
+{
+    mem_free(MEM_EVALUATION, nnue, sizeof(*nnue));
+}
+
+/********************************************************************
+ * nnue_refresh: Biases plus the rows of all pieces on the board.   *
+ ********************************************************************/
+void nnue_refresh(const Nnue nnue, Nnue_accumulator *accumulator, const Game_state *state)
+{
+    for (int perspective = 0; perspective < 2; perspective++)
+    {
+        memcpy(accumulator->values[perspective], nnue->feature_biases, sizeof(nnue->feature_biases));
+        for (int i = 0; i < BOARD_ROWS; i++)
+        {
+            for (int j = 0; j < BOARD_COLUMNS; j++)
+            {
+                if (EMPTY != state->board[i][j].kind)
+                    add_row(accumulator->values[perspective],
+                            nnue->feature_weights[feature_index(state->board[i][j], i, j, perspective)]);
+            }
+        }
+    }
+}
+
+/********************************************************************
+ * nnue_update: Every change removes the row of the old piece and   *
+ *              adds the one of the new piece.                      *
+ ********************************************************************/
+void nnue_update(const Nnue nnue, Nnue_accumulator *accumulator, const Nnue_accumulator *previous, const Game_state *state)
+{
+    if (GAME_STATE_CHANGES < state->changes_number)
+    {
+        nnue_refresh(nnue, accumulator, state);
+        return;
+    }
+
+    if (accumulator != previous)
+        *accumulator = *previous;
+    for (int i = 0; i < state->changes_number; i++)
+    {
+        const Square_change *change = &state->changes[i];
+        for (int perspective = 0; perspective < 2; perspective++)
+        {
+            if (EMPTY != change->old_piece.kind)
+                subtract_row(accumulator->values[perspective],
+                             nnue->feature_weights[feature_index(change->old_piece, change->square.row, change->square.column, perspective)]);
+            if (EMPTY != change->new_piece.kind)
+                add_row(accumulator->values[perspective],
+                        nnue->feature_weights[feature_index(change->new_piece, change->square.row, change->square.column, perspective)]);
+        }
+    }
+}
+
+/********************************************************************
+ * nnue_evaluate: The player to move uses the first half of the     *
+ *                output weights.                                   *
+ ********************************************************************/
+int nnue_evaluate(const Nnue nnue, const Nnue_accumulator *accumulator, const Game_state *state)
+{
+    // move_number counts half-moves starting with 1 for white
+    int us = (1 == state->move_number % 2) ? 0 : 1;
+    int32_t sum = nnue->output_bias
+                + output_sum(accumulator->values[us], nnue->output_weights)
+                + output_sum(accumulator->values[!us], nnue->output_weights + NNUE_HIDDEN);
+    return sum / NNUE_DIVISOR;
+}
+
+/********************************************************************
+ * feature_index: Returns the input of piece on (row, column) seen  *
+ *                from perspective (0 for white, 1 for black).      *
+ *                Black sees the board mirrored vertically, so both *
+ *                perspectives share the same weights.              *
+ ********************************************************************/
+PRIVATE int feature_index(Piece_i piece, int row, int column, int perspective)
+{
+    int square = 8 * row + column;
+    if (1 == perspective)
+        square ^= 56;
+    int enemy = ((WHITE_i == piece.color) == (0 == perspective)) ? 0 : 1;
+    return 64 * (6 * enemy + (piece.kind - PAWN)) + square;
+}
+
+/********************************************************************
+ * add_row: values += row, NNUE_HIDDEN int16 values each.           *
+ ********************************************************************/
+PRIVATE void add_row(int16_t *values, const int16_t *row)
+{
+    int j = 0;
+#if defined(__AVX2__)
+    for (; j + 16 <= NNUE_HIDDEN; j += 16)
+    {
+        __m256i sum = _mm256_add_epi16(_mm256_loadu_si256((const __m256i *) &values[j]),
+                                       _mm256_loadu_si256((const __m256i *) &row[j]));
+        _mm256_storeu_si256((__m256i *) &values[j], sum);
+    }
+#elif defined(__SSE2__)
+    for (; j + 8 <= NNUE_HIDDEN; j += 8)
+    {
+        __m128i sum = _mm_add_epi16(_mm_loadu_si128((const __m128i *) &values[j]),
+                                    _mm_loadu_si128((const __m128i *) &row[j]));
+        _mm_storeu_si128((__m128i *) &values[j], sum);
+    }
+#endif
+    for (; j < NNUE_HIDDEN; j++)
+        values[j] += row[j];
+}
+
+/********************************************************************
+ * subtract_row: values -= row, NNUE_HIDDEN int16 values each.      *
+ ********************************************************************/
+PRIVATE void subtract_row(int16_t *values, const int16_t *row)
+{
+    int j = 0;
+#if defined(__AVX2__)
+    for (; j + 16 <= NNUE_HIDDEN; j += 16)
+    {
+        __m256i difference = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i *) &values[j]),
+                                              _mm256_loadu_si256((const __m256i *) &row[j]));
+        _mm256_storeu_si256((__m256i *) &values[j], difference);
+    }
+#elif defined(__SSE2__)
+    for (; j + 8 <= NNUE_HIDDEN; j += 8)
+    {
+        __m128i difference = _mm_sub_epi16(_mm_loadu_si128((const __m128i *) &values[j]),
+                                           _mm_loadu_si128((const __m128i *) &row[j]));
+        _mm_storeu_si128((__m128i *) &values[j], difference);
+    }
+#endif
+    for (; j < NNUE_HIDDEN; j++)
+        values[j] -= row[j];
+}
+
+/********************************************************************
+ * output_sum: Returns the sum of clip(values[j]) * weights[j] for  *
+ *             the NNUE_HIDDEN values of one perspective.           *
+ *             AVX2 packs the clipped values into unsigned bytes    *
+ *             and multiplies them with the int8 weights directly   *
+ *             (pairs of products fit into int16, since             *
+ *             2 * 127 * 128 < 32768). SSE2 has no such             *
+ *             instruction, so there the weights are widened to     *
+ *             int16.                                               *
+ ********************************************************************/
+PRIVATE int32_t output_sum(const int16_t *values, const int8_t *weights)
+{
+    int32_t sum = 0;
+    int j = 0;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i clip = _mm256_set1_epi16(NNUE_CLIP);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sums = _mm256_setzero_si256();
+    for (; j + 32 <= NNUE_HIDDEN; j += 32)
+    {
+        __m256i low = _mm256_loadu_si256((const __m256i *) &values[j]);
+        __m256i high = _mm256_loadu_si256((const __m256i *) &values[j + 16]);
+        low = _mm256_min_epi16(_mm256_max_epi16(low, zero), clip);
+        high = _mm256_min_epi16(_mm256_max_epi16(high, zero), clip);
+        // packus works within 128 bit lanes, the permutation restores the order
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        __m256i products = _mm256_maddubs_epi16(bytes, _mm256_loadu_si256((const __m256i *) &weights[j]));
+        sums = _mm256_add_epi32(sums, _mm256_madd_epi16(products, ones));
+    }
+    __m128i sums_128 = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    sums_128 = _mm_add_epi32(sums_128, _mm_shuffle_epi32(sums_128, 0x4E));
+    sums_128 = _mm_add_epi32(sums_128, _mm_shuffle_epi32(sums_128, 0xB1));
+    sum += _mm_cvtsi128_si32(sums_128);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i clip = _mm_set1_epi16(NNUE_CLIP);
+    __m128i sums = _mm_setzero_si128();
+    for (; j + 8 <= NNUE_HIDDEN; j += 8)
+    {
+        __m128i clipped = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *) &values[j]), zero), clip);
+        __m128i bytes = _mm_loadl_epi64((const __m128i *) &weights[j]);
+        // every byte into the high half of a 16 bit lane, then shifted down keeping the sign
+        __m128i widened = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+        sums = _mm_add_epi32(sums, _mm_madd_epi16(clipped, widened));
+    }
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, 0x4E));
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, 0xB1));
+    sum += _mm_cvtsi128_si32(sums);
+#endif
+    for (; j < NNUE_HIDDEN; j++)
+    {
+        int32_t value = values[j];
+        if (0 > value)
+            value = 0;
+        else if (NNUE_CLIP < value)
+            value = NNUE_CLIP;
+        sum += value * weights[j];
+    }
+    return sum;
+}
+
+/********************************************************************
+ * read_u32: Reads a little endian uint32.                          *
+ ********************************************************************/
+PRIVATE uint32_t read_u32(const unsigned char *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
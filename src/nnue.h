@@ -0,0 +1,89 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+/********************************************************************
+ * nnue.h                                                           *
+ *                                                                  *
+ * Evaluation by a small neural network, which is cheap to update   *
+ * from one Game_state to the next.                                 *
+ *                                                                  *
+ * Network:                                                         *
+ *   NNUE_FEATURES inputs per perspective (white and black): one    *
+ *   for every (own/enemy, kind, square), squares mirrored for      *
+ *   black. The first layer sums the weights of the active inputs   *
+ *   into an accumulator of NNUE_HIDDEN int16 values per            *
+ *   perspective. A move only changes a few inputs, so the          *
+ *   accumulator of a state is the one of the previous state plus   *
+ *   and minus some rows (see Game_state.changes).                  *
+ *   Both accumulators are clipped to [0, 127], the one of the      *
+ *   player to move first, and multiplied with 2 * NNUE_HIDDEN      *
+ *   int8 output weights. (sum + bias) / NNUE_DIVISOR is the        *
+ *   evaluation in centipawns.                                      *
+ *                                                                  *
+ * The inner loops use AVX2 or SSE2, if the compiler targets those  *
+ * instruction sets (e.g. with -mavx2 or -march=native).            *
+ *                                                                  *
+ * File format (little endian):                                     *
+ *   16 byte header: "CHNN", version, NNUE_FEATURES, NNUE_HIDDEN    *
+ *   (uint32 each)                                                  *
+ *   int16 feature weights[NNUE_FEATURES][NNUE_HIDDEN]              *
+ *   int16 feature biases[NNUE_HIDDEN]                              *
+ *   int8  output weights[2 * NNUE_HIDDEN]                          *
+ *   int32 output bias                                              *
+ ********************************************************************/
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "core_functions.h"
+#include <stdint.h>
+
+#define NNUE_FEATURES 768
+#define NNUE_HIDDEN 128
+#define NNUE_DIVISOR 64
+#define NNUE_VERSION 1
+
+typedef struct nnue *Nnue;
+
+/********************************************************************
+ * Nnue_accumulator: The first layer of the network for one         *
+ *                   Game_state. values[0] is seen from white,      *
+ *                   values[1] from black.                          *
+ ********************************************************************/
+typedef struct nnue_accumulator {
+    int16_t values[2][NNUE_HIDDEN];
+} Nnue_accumulator;
+
+/********************************************************************
+ * nnue_load: Reads the network at path.                            *
+ *            Returns NULL if the file can not be read or does not  *
+ *            match the format.                                     *
+ ********************************************************************/
+Nnue nnue_load(const char *path);
+
+/********************************************************************
+ * nnue_destroy: Frees nnue.                                        *
+ ********************************************************************/
+void nnue_destroy(Nnue nnue);
+
+/********************************************************************
+ * nnue_refresh: Computes the accumulator of state from scratch.    *
+ ********************************************************************/
+void nnue_refresh(const Nnue nnue, Nnue_accumulator *accumulator, const Game_state *state);
+
+/********************************************************************
+ * nnue_update: Computes the accumulator of state from previous,    *
+ *              the accumulator of state->previous_state, using     *
+ *              the changes recorded in state. Falls back to        *
+ *              nnue_refresh() if not all changes were recorded.    *
+ *              accumulator and previous may be the same.           *
+ ********************************************************************/
+void nnue_update(const Nnue nnue, Nnue_accumulator *accumulator, const Nnue_accumulator *previous, const Game_state *state);
+
+/********************************************************************
+ * nnue_evaluate: Returns the evaluation of state seen from the     *
+ *                player to move. accumulator has to belong to      *
+ *                state.                                            *
+ ********************************************************************/
+int nnue_evaluate(const Nnue nnue, const Nnue_accumulator *accumulator, const Game_state *state);
+
+#endif
@@ -0,0 +1,224 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+#define PRIVATE static
+
+#include "opening_book.h"
+#include "core_interface.h"
+#include "mem_utilities.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BOOK_ENTRY_SIZE 16
+// more entries for one position are very unusual
+#define BOOK_MAX_MOVES 64
+
+struct opening_book
+{
+    const unsigned char *data;
+    size_t size;
+    int entries_number;
+};
+
+PRIVATE uint64_t read_big_endian(const unsigned char *bytes, int length);
+PRIVATE uint64_t entry_key(const Opening_book book, int index);
+PRIVATE Book_entry decode_entry(const Opening_book book, int index);
+PRIVATE Move castle_to_king_move(const Game game, Move move);
+
+/********************************************************************
+ * book_open: An empty file can not be mapped, it is treated as a   *
+ *            book without entries.                                 *
+ ********************************************************************/
+Opening_book book_open(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (-1 == fd)
+        return NULL;
+
+    struct stat file_stat;
+    if ((-1 == fstat(fd, &file_stat)) || (0 != file_stat.st_size % BOOK_ENTRY_SIZE))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    const unsigned char *data = NULL;
+    if (0 < file_stat.st_size)
+    {
+        data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == data)
+        {
+            close(fd);
+            return NULL;
+        }
+    }
+    // the mapping stays valid after closing the file
+    close(fd);
+
+    Opening_book book = mem_alloc(MEM_BOOK, sizeof(*book));
+    book->data = data;
+    book->size = file_stat.st_size;
+    book->entries_number = file_stat.st_size / BOOK_ENTRY_SIZE;
+    return book;
+}
+
+/********************************************************************
+ * book_close: Unmaps the book and frees it.                        *
+ ********************************************************************/
+void book_close(Opening_book book)
+{
+    if (NULL != book->data)
+        munmap((void *) book->data, book->size);
+    mem_free(MEM_BOOK, book, sizeof(*book));
+}
+
+/********************************************************************
+ * book_entries_number: Returns the number of entries in book.      *
+ ********************************************************************/
+int book_entries_number(const Opening_book book)
+{
+    return book->entries_number;
+}
+
+/********************************************************************
+ * book_probe: Binary search for the first entry with key. All      *
+ *             entries with the same key follow it.                 *
+ ********************************************************************/
+int book_probe(const Opening_book book, uint64_t key, Book_entry *entries, int max_entries)
+{
+    int low = 0;
+    int high = book->entries_number;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (entry_key(book, middle) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    int entries_number = 0;
+    for (int i = low; (i < book->entries_number) && (entries_number < max_entries); i++)
+    {
+        if (key != entry_key(book, i))
+            break;
+        entries[entries_number++] = decode_entry(book, i);
+    }
+    return entries_number;
+}
+
+/********************************************************************
+ * book_move: Illegal moves are removed before selecting, so they   *
+ *            do not shift the probabilities of the others.         *
+ ********************************************************************/
+bool book_move(const Opening_book book, const Game game, Book_selection selection, Move *move, Letter_piece *promotion)
+{
+    Book_entry entries[BOOK_MAX_MOVES];
+    int entries_number = book_probe(book, position_key(game), entries, BOOK_MAX_MOVES);
+
+    int candidates_number = 0;
+    long total_weight = 0;
+    for (int i = 0; i < entries_number; i++)
+    {
+        entries[i].move = castle_to_king_move(game, entries[i].move);
+        if ((0 < entries[i].weight) && move_possible(game, entries[i].move))
+        {
+            entries[candidates_number++] = entries[i];
+            total_weight += entries[i].weight;
+        }
+    }
+    if (0 == candidates_number)
+        return false;
+
+    int chosen = 0;
+    if (BOOK_BEST == selection)
+    {
+        for (int i = 1; i < candidates_number; i++)
+        {
+            if (entries[i].weight > entries[chosen].weight)
+                chosen = i;
+        }
+    }
+    else
+    {
+        long pick = rand() % total_weight;
+        while (pick >= entries[chosen].weight)
+            pick -= entries[chosen++].weight;
+    }
+
+    *move = entries[chosen].move;
+    if (NULL != promotion)
+    {
+        Letter_piece letter = entries[chosen].promotion;
+        if (('\0' != letter) && (BLACK == player_to_move(game)))
+            letter = letter - 'A' + 'a';
+        *promotion = letter;
+    }
+    return true;
+}
+
+/********************************************************************
+ * read_big_endian: Reads length bytes as big-endian number.        *
+ ********************************************************************/
+PRIVATE uint64_t read_big_endian(const unsigned char *bytes, int length)
+{
+    uint64_t number = 0;
+    for (int i = 0; i < length; i++)
+        number = (number << 8) | bytes[i];
+    return number;
+}
+
+/********************************************************************
+ * entry_key: Returns the key of entry index.                       *
+ ********************************************************************/
+PRIVATE uint64_t entry_key(const Opening_book book, int index)
+{
+    return read_big_endian(book->data + (size_t) index * BOOK_ENTRY_SIZE, 8);
+}
+
+/********************************************************************
+ * decode_entry: Rows and columns of the move are 0 - 7 in both     *
+ *               Polyglot and core_interface, with row 0 being the  *
+ *               first rank.                                        *
+ ********************************************************************/
+PRIVATE Book_entry decode_entry(const Opening_book book, int index)
+{
+    static const Letter_piece promotions[] = {'\0', 'N', 'B', 'R', 'Q'};
+    const unsigned char *entry = book->data + (size_t) index * BOOK_ENTRY_SIZE;
+    int move = read_big_endian(entry + 8, 2);
+    int promotion = (move >> 12) & 7;
+
+    return (Book_entry) {
+        .key = read_big_endian(entry, 8),
+        .move = (Move) { (Square) {(move >> 9) & 7, (move >> 6) & 7}, (Square) {(move >> 3) & 7, move & 7} },
+        .promotion = (promotion < 5) ? promotions[promotion] : '\0',
+        .weight = read_big_endian(entry + 10, 2),
+    };
+}
+
+/********************************************************************
+ * castle_to_king_move: Polyglot encodes castling as e1h1, e1a1,    *
+ *                      e8h8 and e8a8. If there is a king on the    *
+ *                      starting square, these are turned into the  *
+ *                      king moves e1g1, e1c1, e8g8 and e8c8.       *
+ ********************************************************************/
+PRIVATE Move castle_to_king_move(const Game game, Move move)
+{
+    if ((4 != move.from.column) || (move.from.row != move.to.row)
+     || ((0 != move.from.row) && (BOARD_ROWS - 1 != move.from.row))
+     || ((0 != move.to.column) && (BOARD_COLUMNS - 1 != move.to.column)))
+        return move;
+
+    // current_board() starts with the last row
+    Letter_piece piece = current_board(game)[(BOARD_ROWS - 1 - move.from.row) * BOARD_COLUMNS + move.from.column];
+    if ((WHITE_KING != piece) && (BLACK_KING != piece))
+        return move;
+
+    move.to.column = (0 == move.to.column) ? 2 : 6;
+    return move;
+}
@@ -0,0 +1,89 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+/********************************************************************
+ * opening_book.h                                                   *
+ *                                                                  *
+ * Reads opening books in the Polyglot .bin format. A book is a     *
+ * file of 16-byte entries, sorted by key:                          *
+ *    key     64 bit  zobrist key of the position (see zobrist.h)   *
+ *    move    16 bit  to column, to row, from column, from row,     *
+ *                    promotion (3 bits each, lowest bits first)    *
+ *    weight  16 bit  how often the move should be chosen           *
+ *    learn   32 bit  unused                                        *
+ * All numbers are big-endian.                                      *
+ * The file is memory-mapped, so opening a book costs nothing and   *
+ * probing only touches the pages visited by the binary search.     *
+ *                                                                  *
+ * Keys are computed with the Polyglot Random64 table (see          *
+ * zobrist.h), so books made by other programs can be probed.       *
+ ********************************************************************/
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include "core_interface.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct opening_book *Opening_book;
+
+/********************************************************************
+ * Book_entry: A decoded entry of a book.                           *
+ *             promotion is 'N', 'B', 'R', 'Q' or '\0'.             *
+ *             Castling is stored as in Polyglot: as the king       *
+ *             moving onto its own rook.                            *
+ ********************************************************************/
+typedef struct book_entry {
+    uint64_t key;
+    Move move;
+    Letter_piece promotion;
+    int weight;
+} Book_entry;
+
+/********************************************************************
+ * Book_selection: BOOK_BEST always picks the move with the highest *
+ *                 weight, BOOK_WEIGHTED picks at random with       *
+ *                 probabilities proportional to the weights.       *
+ ********************************************************************/
+typedef enum book_selection {
+    BOOK_BEST, BOOK_WEIGHTED,
+} Book_selection;
+
+/********************************************************************
+ * book_open: Maps the book at path into memory.                    *
+ *            Returns NULL if the file can not be opened or mapped  *
+ *            or if it's size is not a multiple of 16 bytes.        *
+ ********************************************************************/
+Opening_book book_open(const char *path);
+
+/********************************************************************
+ * book_close: Unmaps the book and frees it.                        *
+ ********************************************************************/
+void book_close(Opening_book book);
+
+/********************************************************************
+ * book_entries_number: Returns the number of entries in book.      *
+ ********************************************************************/
+int book_entries_number(const Opening_book book);
+
+/********************************************************************
+ * book_probe: Writes up to max_entries entries with key into       *
+ *             entries, in the order they are stored in the book.   *
+ *             Returns the number of entries written.               *
+ ********************************************************************/
+int book_probe(const Opening_book book, uint64_t key, Book_entry *entries, int max_entries);
+
+/********************************************************************
+ * book_move: Looks up the current position of game and selects a   *
+ *            move by selection. Castling is converted to the king  *
+ *            move move_piece() expects.                            *
+ *            Moves which are not legal in game (e.g. from key      *
+ *            collisions) and moves with weight 0 are skipped.      *
+ *            Returns false if no move is found.                    *
+ *            If promotion is not NULL, the promotion piece (in the *
+ *            case of the player to move) or '\0' is written to it, *
+ *            to be passed to upgrade_pawn().                       *
+ ********************************************************************/
+bool book_move(const Opening_book book, const Game game, Book_selection selection, Move *move, Letter_piece *promotion);
+
+#endif
@@ -0,0 +1,234 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+//
+// pgn_parsing.c
+// splits pgn movetext into tokens
+//
+// Most of the time of scanning movetext is spent looking for the
+// beginning and the end of tokens. This is done on 32 (AVX2) or
+// 16 (SSE2) bytes at once, if the compiler targets those instruction
+// sets (e.g. with -mavx2 or -march=native). Otherwise, and for the
+// last bytes of the buffer, the scalar versions are used.
+//
+
+#include "pgn_parsing.h"
+#include "san_parsing.h"
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define PRIVATE static
+
+PRIVATE const char *skip_whitespace(const char *p, const char *end);
+PRIVATE const char *find_delimiter(const char *p, const char *end);
+PRIVATE bool is_delimiter(char c);
+PRIVATE bool is_result(const char *p, const char *end);
+
+/////////////////////////////////////////////////////////////////////
+// pgn_scan(): Every iteration skips whitespace, then looks at the
+//             first character to decide which kind of token
+//             follows.
+/////////////////////////////////////////////////////////////////////
+int pgn_scan(const char *buffer, int length, Pgn_token *tokens, int max_tokens, int *scanned)
+{
+    const char *p = buffer;
+    const char *end = buffer + length;
+    const char *found;
+    int tokens_number = 0;
+
+    for (;;)
+    {
+        p = skip_whitespace(p, end);
+        if ((p == end) || (tokens_number == max_tokens))
+            break;
+
+        const char *start = p;
+        pgn_token_type type;
+        san_type san = INVALID_SAN;
+        switch (*p)
+        {
+            case '{':   found = memchr(p, '}', end - p);
+                        p = (NULL == found) ? end : found + 1;
+                        type = PGN_COMMENT;
+                        break;
+            case ';':   found = memchr(p, '\n', end - p);
+                        p = (NULL == found) ? end : found;
+                        type = PGN_COMMENT;
+                        break;
+            case '(':   p++;
+                        type = PGN_VARIATION_START;
+                        break;
+            case ')':   p++;
+                        type = PGN_VARIATION_END;
+                        break;
+            case '$':   p++;
+                        while ((p < end) && ('0' <= *p) && ('9' >= *p))
+                            p++;
+                        type = PGN_NAG;
+                        break;
+            default:    found = find_delimiter(p, end);
+                        if (is_result(p, found))
+                        {
+                            p = found;
+                            type = PGN_RESULT;
+                        }
+                        // a move number can be directly followed by the move, e.g. "1.e4"
+                        else if (('0' <= *p) && ('9' >= *p))
+                        {
+                            while ((p < found) && ('0' <= *p) && ('9' >= *p))
+                                p++;
+                            while ((p < found) && ('.' == *p))
+                                p++;
+                            type = PGN_MOVE_NUMBER;
+                        }
+                        else
+                        {
+                            san = san_lex_length(p, found - p).type;
+                            p = found;
+                            type = PGN_SAN;
+                        }
+                        break;
+        }
+
+        tokens[tokens_number++] = (Pgn_token) { type, san, start - buffer, p - start };
+    }
+
+    if (NULL != scanned)
+        *scanned = p - buffer;
+    return tokens_number;
+}
+
+/////////////////////////////////////////////////////////////////////
+// pgn_first_invalid(): Returns the index of the first PGN_SAN
+//                      token in tokens which is INVALID_SAN or -1
+//                      if all moves are valid.
+/////////////////////////////////////////////////////////////////////
+int pgn_first_invalid(const Pgn_token *tokens, int tokens_number)
+{
+    for (int i = 0; i < tokens_number; i++)
+    {
+        if ((PGN_SAN == tokens[i].type) && (INVALID_SAN == tokens[i].san))
+            return i;
+    }
+    return -1;
+}
+
+/////////////////////////////////////////////////////////////////////
+// skip_whitespace(): Returns a pointer to the first character in
+//                    [p, end) which is not whitespace, or end.
+//                    All characters up to ' ' count as whitespace.
+//                    The comparison x <= ' ' is done as
+//                    min(x, ' ') == x, because SSE2 and AVX2 only
+//                    have signed byte comparisons.
+/////////////////////////////////////////////////////////////////////
+PRIVATE const char *skip_whitespace(const char *p, const char *end)
+{
+#if defined(__AVX2__)
+    const __m256i space_32 = _mm256_set1_epi8(' ');
+    while (end - p >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *) p);
+        __m256i space = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, space_32), chunk);
+        unsigned int mask = ~(unsigned int) _mm256_movemask_epi8(space);
+        if (0 != mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i space_16 = _mm_set1_epi8(' ');
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) p);
+        __m128i space = _mm_cmpeq_epi8(_mm_min_epu8(chunk, space_16), chunk);
+        unsigned int mask = ~(unsigned int) _mm_movemask_epi8(space) & 0xFFFF;
+        if (0 != mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while ((p < end) && ((unsigned char) *p <= ' '))
+        p++;
+    return p;
+}
+
+/////////////////////////////////////////////////////////////////////
+// find_delimiter(): Returns a pointer to the first character in
+//                   [p, end) which ends a move token (see
+//                   is_delimiter()), or end.
+/////////////////////////////////////////////////////////////////////
+PRIVATE const char *find_delimiter(const char *p, const char *end)
+{
+#if defined(__AVX2__)
+    const __m256i space_32 = _mm256_set1_epi8(' ');
+    const __m256i open_32 = _mm256_set1_epi8('(');
+    const __m256i close_32 = _mm256_set1_epi8(')');
+    const __m256i semicolon_32 = _mm256_set1_epi8(';');
+    const __m256i brace_32 = _mm256_set1_epi8('{');
+    while (end - p >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *) p);
+        __m256i delimiter = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, space_32), chunk);
+        delimiter = _mm256_or_si256(delimiter, _mm256_cmpeq_epi8(chunk, open_32));
+        delimiter = _mm256_or_si256(delimiter, _mm256_cmpeq_epi8(chunk, close_32));
+        delimiter = _mm256_or_si256(delimiter, _mm256_cmpeq_epi8(chunk, semicolon_32));
+        delimiter = _mm256_or_si256(delimiter, _mm256_cmpeq_epi8(chunk, brace_32));
+        unsigned int mask = (unsigned int) _mm256_movemask_epi8(delimiter);
+        if (0 != mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i space_16 = _mm_set1_epi8(' ');
+    const __m128i open_16 = _mm_set1_epi8('(');
+    const __m128i close_16 = _mm_set1_epi8(')');
+    const __m128i semicolon_16 = _mm_set1_epi8(';');
+    const __m128i brace_16 = _mm_set1_epi8('{');
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) p);
+        __m128i delimiter = _mm_cmpeq_epi8(_mm_min_epu8(chunk, space_16), chunk);
+        delimiter = _mm_or_si128(delimiter, _mm_cmpeq_epi8(chunk, open_16));
+        delimiter = _mm_or_si128(delimiter, _mm_cmpeq_epi8(chunk, close_16));
+        delimiter = _mm_or_si128(delimiter, _mm_cmpeq_epi8(chunk, semicolon_16));
+        delimiter = _mm_or_si128(delimiter, _mm_cmpeq_epi8(chunk, brace_16));
+        unsigned int mask = (unsigned int) _mm_movemask_epi8(delimiter);
+        if (0 != mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while ((p < end) && !is_delimiter(*p))
+        p++;
+    return p;
+}
+
+/////////////////////////////////////////////////////////////////////
+// is_delimiter(): Whitespace and the characters starting comments
+//                 and variations end a move token.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool is_delimiter(char c)
+{
+    return ((unsigned char) c <= ' ') || ('(' == c) || (')' == c) || (';' == c) || ('{' == c);
+}
+
+/////////////////////////////////////////////////////////////////////
+// is_result(): Checks if [p, end) is one of the four game results.
+/////////////////////////////////////////////////////////////////////
+PRIVATE bool is_result(const char *p, const char *end)
+{
+    switch (end - p)
+    {
+        case 1:     return '*' == *p;
+        case 3:     return (0 == memcmp(p, "1-0", 3)) || (0 == memcmp(p, "0-1", 3));
+        case 7:     return 0 == memcmp(p, "1/2-1/2", 7);
+        default:    return false;
+    }
+}
@@ -0,0 +1,65 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+//
+// pgn_parsing.h
+// splits pgn movetext into tokens
+// pgn stands for "portable game notation"
+// see: https://en.wikipedia.org/wiki/Portable_Game_Notation for an explanation
+//
+
+#ifndef PGN_PARSING_H
+#define PGN_PARSING_H
+
+#include "san_parsing.h"
+
+/////////////////////////////////////////////////////////////////////
+// pgn_token_type: Kinds of tokens found in movetext.
+//                 PGN_SAN is used for everything, that is not one
+//                 of the other kinds. Pgn_token.san tells if it is
+//                 a valid san move.
+/////////////////////////////////////////////////////////////////////
+typedef enum {
+    PGN_SAN = 0,
+    PGN_MOVE_NUMBER,        // "12." or "12..."
+    PGN_NAG,                // "$12"
+    PGN_COMMENT,            // "{...}" or "; ... " up to the end of the line
+    PGN_VARIATION_START,    // "("
+    PGN_VARIATION_END,      // ")"
+    PGN_RESULT,             // "1-0", "0-1", "1/2-1/2" or "*"
+} pgn_token_type;
+
+/////////////////////////////////////////////////////////////////////
+// Pgn_token: start and length give the position of the token in
+//            the scanned buffer.
+//            san is INVALID_SAN for all types except PGN_SAN.
+/////////////////////////////////////////////////////////////////////
+typedef struct pgn_token {
+    pgn_token_type type;
+    san_type san;
+    int start;
+    int length;
+} Pgn_token;
+
+/////////////////////////////////////////////////////////////////////
+// pgn_scan(): Splits the first length characters of buffer into
+//             tokens and writes up to max_tokens of them into
+//             tokens.
+//             Returns the number of tokens written.
+//             The number of characters processed is written to
+//             *scanned (if scanned is not NULL). It is smaller than
+//             length if tokens ran full, in which case scanning can
+//             be continued at buffer + *scanned.
+//             Whitespace is skipped 16 or 32 bytes at a time if
+//             the compiler targets SSE2 or AVX2.
+/////////////////////////////////////////////////////////////////////
+int pgn_scan(const char *buffer, int length, Pgn_token *tokens, int max_tokens, int *scanned);
+
+/////////////////////////////////////////////////////////////////////
+// pgn_first_invalid(): Returns the index of the first PGN_SAN
+//                      token in tokens which is INVALID_SAN or -1
+//                      if all moves are valid.
+/////////////////////////////////////////////////////////////////////
+int pgn_first_invalid(const Pgn_token *tokens, int tokens_number);
+
+#endif // PGN_PARSING_H
@@ -9,9 +9,105 @@
 
 #define PRIVATE static
 
-PRIVATE san_type san_type_pawn(const char *input);
-PRIVATE san_type san_type_piece(const char *input);
-PRIVATE san_type san_type_castle(const char *input);
+PRIVATE San_move san_lex_span(const char *input, const char *end);
+
+// character classes of the san lexer
+typedef enum {
+    CC_OTHER = 0,
+    CC_END,
+    CC_FILE,
+    CC_RANK,            // '2' - '7'
+    CC_RANK_EDGE,       // '1' and '8', where pawns have to promote
+    CC_PIECE,           // 'N', 'B', 'R', 'Q' (valid promotions)
+    CC_KING,
+    CC_TAKES,
+    CC_PROMOTE,
+    CC_CASTLE,
+    CC_DASH,
+    CC_CHECK,
+    CC_ANNOTATION,
+    CC_NUMBER,          // number of character classes
+} Char_class;
+
+// states of the san lexer
+// S_ERROR is 0, so that all transitions not listed in the table fail
+typedef enum {
+    S_ERROR = 0,
+    S_START,
+    S_PIECE,            // "N"
+    S_PIECE_FILE,       // "Nb"
+    S_PIECE_RANK,       // "N1"
+    S_PIECE_SQUARE,     // "Nb1"     target or disambiguation
+    S_TAKES,            // "Nx"      waits for target file
+    S_TARGET_FILE,      // "Nbd"     waits for target rank
+    S_PAWN_FILE,        // "e"
+    S_PAWN_TAKES,       // "ex"
+    S_PAWN_TARGET_FILE, // "exd"
+    S_PAWN_EDGE,        // "e8"      waits for '='
+    S_PROMOTE,          // "e8="     waits for piece
+    S_DONE,             // complete move, only suffixes may follow
+    S_CASTLE_O1,        // "O"
+    S_CASTLE_DASH1,     // "O-"
+    S_CASTLE_SHORT,     // "O-O"
+    S_CASTLE_DASH2,     // "O-O-"
+    S_CASTLE_LONG,      // "O-O-O"
+    S_CHECK,            // "+" or "#"
+    S_ANNOTATION_1,     // "!" or "?"
+    S_ANNOTATION_2,     // "!!", "!?", ...
+    S_ACCEPT,
+    S_NUMBER,           // number of states
+} Lexer_state;
+
+PRIVATE const unsigned char san_char_class[256] = {
+    ['\0'] = CC_END,
+    ['a'] = CC_FILE, ['b'] = CC_FILE, ['c'] = CC_FILE, ['d'] = CC_FILE,
+    ['e'] = CC_FILE, ['f'] = CC_FILE, ['g'] = CC_FILE, ['h'] = CC_FILE,
+    ['1'] = CC_RANK_EDGE, ['2'] = CC_RANK, ['3'] = CC_RANK, ['4'] = CC_RANK,
+    ['5'] = CC_RANK, ['6'] = CC_RANK, ['7'] = CC_RANK, ['8'] = CC_RANK_EDGE,
+    ['N'] = CC_PIECE, ['B'] = CC_PIECE, ['R'] = CC_PIECE, ['Q'] = CC_PIECE,
+    ['K'] = CC_KING,
+    ['x'] = CC_TAKES,
+    ['='] = CC_PROMOTE,
+    ['O'] = CC_CASTLE,
+    ['-'] = CC_DASH,
+    ['+'] = CC_CHECK, ['#'] = CC_CHECK,
+    ['!'] = CC_ANNOTATION, ['?'] = CC_ANNOTATION,
+};
+
+PRIVATE const unsigned char san_transitions[S_NUMBER][CC_NUMBER] = {
+    [S_START]            = { [CC_FILE] = S_PAWN_FILE, [CC_PIECE] = S_PIECE, [CC_KING] = S_PIECE,
+                             [CC_CASTLE] = S_CASTLE_O1 },
+    [S_PIECE]            = { [CC_FILE] = S_PIECE_FILE, [CC_RANK] = S_PIECE_RANK, [CC_RANK_EDGE] = S_PIECE_RANK,
+                             [CC_TAKES] = S_TAKES },
+    [S_PIECE_FILE]       = { [CC_FILE] = S_TARGET_FILE, [CC_RANK] = S_PIECE_SQUARE, [CC_RANK_EDGE] = S_PIECE_SQUARE,
+                             [CC_TAKES] = S_TAKES },
+    [S_PIECE_RANK]       = { [CC_FILE] = S_TARGET_FILE, [CC_TAKES] = S_TAKES },
+    [S_PIECE_SQUARE]     = { [CC_END] = S_ACCEPT, [CC_FILE] = S_TARGET_FILE, [CC_TAKES] = S_TAKES,
+                             [CC_CHECK] = S_CHECK, [CC_ANNOTATION] = S_ANNOTATION_1 },
+    [S_TAKES]            = { [CC_FILE] = S_TARGET_FILE },
+    [S_TARGET_FILE]      = { [CC_RANK] = S_DONE, [CC_RANK_EDGE] = S_DONE },
+    [S_PAWN_FILE]        = { [CC_RANK] = S_DONE, [CC_RANK_EDGE] = S_PAWN_EDGE, [CC_TAKES] = S_PAWN_TAKES },
+    [S_PAWN_TAKES]       = { [CC_FILE] = S_PAWN_TARGET_FILE },
+    [S_PAWN_TARGET_FILE] = { [CC_RANK] = S_DONE, [CC_RANK_EDGE] = S_PAWN_EDGE },
+    [S_PAWN_EDGE]        = { [CC_PROMOTE] = S_PROMOTE },
+    [S_PROMOTE]          = { [CC_PIECE] = S_DONE },
+    [S_DONE]             = { [CC_END] = S_ACCEPT, [CC_CHECK] = S_CHECK, [CC_ANNOTATION] = S_ANNOTATION_1 },
+    [S_CASTLE_O1]        = { [CC_DASH] = S_CASTLE_DASH1 },
+    [S_CASTLE_DASH1]     = { [CC_CASTLE] = S_CASTLE_SHORT },
+    [S_CASTLE_SHORT]     = { [CC_END] = S_ACCEPT, [CC_DASH] = S_CASTLE_DASH2,
+                             [CC_CHECK] = S_CHECK, [CC_ANNOTATION] = S_ANNOTATION_1 },
+    [S_CASTLE_DASH2]     = { [CC_CASTLE] = S_CASTLE_LONG },
+    [S_CASTLE_LONG]      = { [CC_END] = S_ACCEPT, [CC_CHECK] = S_CHECK, [CC_ANNOTATION] = S_ANNOTATION_1 },
+    [S_CHECK]            = { [CC_END] = S_ACCEPT, [CC_ANNOTATION] = S_ANNOTATION_1 },
+    [S_ANNOTATION_1]     = { [CC_END] = S_ACCEPT, [CC_ANNOTATION] = S_ANNOTATION_2 },
+    [S_ANNOTATION_2]     = { [CC_END] = S_ACCEPT },
+};
+
+// san types of piece moves, subscripted by [capture][file given][rank given]
+PRIVATE const san_type san_piece_types[2][2][2] = {
+    { { PIECE_MOVE, PIECE_MOVE_RANK }, { PIECE_MOVE_FILE, PIECE_MOVE_BOTH } },
+    { { PIECE_CAPTURE, PIECE_CAPTURE_RANK }, { PIECE_CAPTURE_FILE, PIECE_CAPTURE_BOTH } },
+};
 
 /////////////////////////////////////////////////////////////////////
 // trim_whitespace(): 
@@ -66,210 +162,124 @@ void trim_whitespace(char *string)
     }
 }
 
+
 /////////////////////////////////////////////////////////////////////
-// get_san_type(): 
+// san_lex(): Walks through input exactly once. Each character is
+//            mapped to its class by san_char_class and the next
+//            state is looked up in san_transitions. Files and ranks
+//            are collected in the order they appear, the last of
+//            them form the target square, earlier ones the
+//            disambiguation.
 /////////////////////////////////////////////////////////////////////
-san_type get_san_type(const char *input)
+San_move san_lex(const char *input)
 {
-    san_type san;
-    if ((san = san_type_pawn(input)))
-        return san;
-    else if ((san = san_type_piece(input)))
-        return san;
-    else
-        return san_type_castle(input);
+    return san_lex_span(input, NULL);
 }
 
-PRIVATE san_type san_type_pawn(const char *input)
+/////////////////////////////////////////////////////////////////////
+// san_lex_length(): Like san_lex() for strings which are not '\0'
+//                   terminated.
+/////////////////////////////////////////////////////////////////////
+San_move san_lex_length(const char *input, int length)
 {
-    switch (*input)
-    {
-        case 'a':
-        case 'b':
-        case 'c':
-        case 'd':
-        case 'e':
-        case 'f':
-        case 'g':
-        case 'h':
-            switch (*(input+1))
-            {
-                case '1':
-                case '8':
-                    // if pawn reaches first or last row, check if the trade-in-piece is specified
-                    if ('=' == *(input+2))
-                        switch (*(input+3))
-                        {
-                            case 'N':
-                            case 'B':
-                            case 'R':
-                            case 'Q':
-                                if ('\0' == *(input+4))
-                                    return PAWN_MOVE_PROMOTE;
-                            default:
-                                return INVALID_SAN;
-                        }
-                    else
-                        return INVALID_SAN;
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                    if ('\0' == *(input+2))
-                        return PAWN_MOVE;
-                    else if ('x' != *(input+1))
-                        return INVALID_SAN;
-                case 'x':
-                    // if pawn captures
-                    // first make sure that columns are neighbours
-                    if (1 != abs(*input - *(input+2)))
-                        return INVALID_SAN;
-                    switch (*(input+2))
-                    {
-                        case 'a':
-                        case 'b':
-                        case 'c':
-                        case 'd':
-                        case 'e':
-                        case 'f':
-                        case 'g':
-                        case 'h':
-                            switch (*(input+3))
-                            {
-                                // if reaches first or last column, check if trade-in-piece is specified
-                                case '1':
-                                case '8':
-                                    if ('=' == *(input+4))
-                                        switch (*(input+5))
-                                        {
-                                            case 'N':
-                                            case 'B':
-                                            case 'R':
-                                            case 'Q':
-                                                if ('\0' == *(input+6))
-                                                    return PAWN_CAPTURE_PROMOTE;
-                                            default:
-                                                return INVALID_SAN;
-                                        }
-                                    else
-                                        return INVALID_SAN;
-                                case '2':
-                                case '3':
-                                case '4':
-                                case '5':
-                                case '6':
-                                case '7':
-                                    if ('\0' == *(input+4))
-                                        return PAWN_CAPTURE;
-                                default:
-                                    return INVALID_SAN;
-                            }
-                        default:
-                            return INVALID_SAN;
-                    }
-                default:
-                    return INVALID_SAN;
-            }
-        default:
-            return INVALID_SAN;
-    }
+    return san_lex_span(input, input + length);
 }
 
-PRIVATE san_type san_type_piece(const char *input)
+/////////////////////////////////////////////////////////////////////
+// san_lex_span(): Implements san_lex() and san_lex_length().
+//                 The input ends at end, or at the first '\0' if
+//                 end is NULL.
+/////////////////////////////////////////////////////////////////////
+PRIVATE San_move san_lex_span(const char *input, const char *end)
 {
-    switch (*input)
+    San_move move = { INVALID_SAN, '\0', -1, -1, -1, -1, false, '\0', '\0' };
+
+    int files[2];
+    int ranks[2];
+    int files_number = 0;
+    int ranks_number = 0;
+    int castle_number = 0;
+
+    Lexer_state state = S_START;
+    const unsigned char *p = (const unsigned char *) input;
+    for (;;)
     {
-        case 'N':
-        case 'B':
-        case 'R':
-        case 'Q':
-        case 'K':
-            if ((*(input + 1) >= 'a') &&
-                (*(input + 1) <= 'h'))
-            {
-                if ((*(input + 2) >= '1') &&
-                    (*(input + 2) <= '8'))
-                {
+        Char_class class;
+        if ((const char *) p == end)
+            class = CC_END;
+        else if ((NULL != end) && ('\0' == *p))
+            class = CC_OTHER;
+        else
+            class = san_char_class[*p];
+        Lexer_state previous = state;
+        state = san_transitions[state][class];
+
+        if (S_ERROR == state)
+            return move;
+        if (S_ACCEPT == state)
+            break;
 
-                    if ('\0' == *(input + 3))
-                        return PIECE_MOVE;
-                    else if ((*(input + 3) >= 'a') &&
-                             (*(input + 3) <= 'h') &&
-                             (*(input + 4) >= '1') &&
-                             (*(input + 4) <= '8') &&
-                             ('\0' == *(input + 5)))
-                        return PIECE_MOVE_BOTH;
-                    else if (('x' == *(input + 3)) &&
-                             (*(input + 4) >= 'a') &&
-                             (*(input + 4) <= 'h') &&
-                             (*(input + 5) >= '1') &&
-                             (*(input + 5) <= '8') &&
-                             ('\0' == *(input + 6)))
-                        return PIECE_CAPTURE_BOTH;
-                    else
-                        return INVALID_SAN;
-                }
-                else if ((*(input + 2) >= 'a') &&
-                         (*(input + 2) <= 'h'))
-                {
-                    if ((*(input + 3) >= '1') &&
-                        (*(input + 3) <= '8') &&
-                        ('\0' == *(input + 4)))
-                        return PIECE_MOVE_FILE;
-                    else
-                        return INVALID_SAN;
-                }
-                else if (('x' == *(input + 2)) &&
-                         (*(input + 3) >= 'a') &&
-                         (*(input + 3) <= 'h') &&
-                         (*(input + 4) >= '1') &&
-                         (*(input + 4) <= '8') &&
-                         ('\0' == *(input + 5)))
-                    return PIECE_CAPTURE_FILE;
-            }
-            else if ((*(input + 1) >= '1') &&
-                     (*(input + 1) <= '8'))
-            {
-                if ((*(input + 2) >= 'a') &&
-                    (*(input + 2) <= 'h') &&
-                    (*(input + 3) >= '1') &&
-                    (*(input + 3) <= '8') &&
-                    ('\0' == *(input + 4)))
-                    return PIECE_MOVE_RANK;
-                else if (('x' == *(input + 2)) &&
-                         (*(input + 3) >= 'a') &&
-                         (*(input + 3) <= 'h') &&
-                         (*(input + 4) >= '1') &&
-                         (*(input + 4) <= '8') &&
-                         ('\0' == *(input + 5)))
-                         return PIECE_CAPTURE_RANK;
-            }
-            else if (('x' == *(input + 1)) &&
-                     (*(input + 2) >= 'a') &&
-                     (*(input + 2) <= 'h') &&
-                     (*(input + 3) >= '1') &&
-                     (*(input + 3) <= '8') &&
-                     ('\0' == *(input + 4)))
-                     return PIECE_CAPTURE;
-        default:
-            return INVALID_SAN;
+        switch (class)
+        {
+            case CC_FILE:       files[files_number++] = *p - 'a';
+                                break;
+            case CC_RANK:
+            case CC_RANK_EDGE:  ranks[ranks_number++] = *p - '1';
+                                break;
+            case CC_PIECE:
+            case CC_KING:       if (S_START == previous)
+                                    move.piece = *p;
+                                else
+                                    move.promotion = *p;
+                                break;
+            case CC_TAKES:      move.capture = true;
+                                break;
+            case CC_CASTLE:     castle_number++;
+                                break;
+            case CC_CHECK:      move.suffix = *p;
+                                break;
+            default:            break;
+        }
+        p++;
     }
-}
 
-PRIVATE san_type san_type_castle(const char *input)
-{
-    if (('O' == *input) &&
-        ('-' == *(input + 1)) &&
-        ('O' == *(input + 2)))
+    if (castle_number)
+    {
+        move.type = (2 == castle_number) ? CASTLE_RIGHT : CASTLE_LEFT;
+        move.piece = 'K';
+        return move;
+    }
+
+    move.to_file = files[files_number - 1];
+    move.to_rank = ranks[ranks_number - 1];
+    if ('\0' == move.piece)
+    {
+        move.piece = 'P';
+        // pawns can only capture on neighbouring files
+        if (move.capture && (1 != abs(files[0] - move.to_file)))
+            return move;
+        move.from_file = files[0];
+        if (move.capture)
+            move.type = move.promotion ? PAWN_CAPTURE_PROMOTE : PAWN_CAPTURE;
+        else
+            move.type = move.promotion ? PAWN_MOVE_PROMOTE : PAWN_MOVE;
+    }
+    else
     {
-        if ('\0' == *(input + 3))
-            return CASTLE_RIGHT;
-        else if (('-' == *(input + 3)) &&
-                 ('O' == *(input + 4)) &&
-                 ('\0' == *(input + 5)))
-            return CASTLE_LEFT;
+        if (2 == files_number)
+            move.from_file = files[0];
+        if (2 == ranks_number)
+            move.from_rank = ranks[0];
+        move.type = san_piece_types[move.capture][2 == files_number][2 == ranks_number];
     }
-    return INVALID_SAN;
+
+    return move;
+}
+
+/////////////////////////////////////////////////////////////////////
+// get_san_type(): Convenience wrapper around san_lex().
+/////////////////////////////////////////////////////////////////////
+san_type get_san_type(const char *input)
+{
+    return san_lex(input).type;
 }
@@ -4,6 +4,8 @@
 #ifndef SAN_PARSING_H
 #define SAN_PARSING_H
 
+#include <stdbool.h>
+
 /////////////////////////////////////////////////////////////////////
 // san_type: san = standard algebraic notation for chess.
 //           These are used as return values, when parsing input.
@@ -34,48 +36,59 @@ typedef enum {
 } san_type;
 
 /////////////////////////////////////////////////////////////////////
-// trim_whitespace(): 
+// San_move: Everything san_lex() extracts from a san string.
+//           Files and ranks are given as 0 - 7 (for 'a' - 'h' and
+//           '1' - '8'), -1 if the string does not specify them.
+//           piece:      'P', 'N', 'B', 'R', 'Q' or 'K'
+//                       ('K' for castling, '\0' if INVALID_SAN)
+//           from_file:  for pawns the file the pawn starts on
+//           promotion:  'N', 'B', 'R', 'Q' or '\0'
+//           suffix:     '+', '#' or '\0'
 /////////////////////////////////////////////////////////////////////
-void trim_whitespace(char *string);
+typedef struct san_move {
+    san_type type;
+    char piece;
+    int from_file;
+    int from_rank;
+    int to_file;
+    int to_rank;
+    bool capture;
+    char promotion;
+    char suffix;
+} San_move;
 
 /////////////////////////////////////////////////////////////////////
-// get_san_type(): 
+// trim_whitespace(): 
 /////////////////////////////////////////////////////////////////////
-san_type get_san_type(const char *input);
+void trim_whitespace(char *string);
 
 /////////////////////////////////////////////////////////////////////
-// san_type_pawn(): checks if string is in correct (export)
-//                  format for a san-pawn-move.
-//                  Input needs to be '\0' terminated and can not
-//                  have leading or trailing whitespace.
-//                  If these conditions don't hold, behavior is
-//                  undefined.
+// san_lex(): Classifies a '\0' terminated san string and extracts
+//            all of its components in a single pass without
+//            backtracking.
+//            Input can not have leading or trailing whitespace.
+//            A check/mate suffix ('+', '#') and up to two
+//            annotation characters ('!', '?') are accepted.
+//            Syntactically correct san expressions, which are
+//            impossible moves in chess, e.g. "Nah3" will not be
+//            returned as INVALID_SAN but as the san_type
+//            corresponding to the syntax. In the case of the
+//            example: PIECE_MOVE_FILE
+//            If type is INVALID_SAN the other members are
+//            undefined.
 /////////////////////////////////////////////////////////////////////
-//san_type san_type_pawn(const char *input);
+San_move san_lex(const char *input);
 
 /////////////////////////////////////////////////////////////////////
-// san_type_piece(): checks if string is in syntactically correct
-//                   (export) format for a san-piece-move.
-//                   Input needs to be '\0' terminated and can not
-//                   have leading or trailing whitespace.
-//                   If these conditions don't hold, behavior is
-//                   undefined.
-//                   Syntactically correct san expressions,
-//                   which are impossible moves in chess,
-//                   e.g. "Nah3" will not be returned as 
-//                   INVALID_SAN but as the san_type corresponding
-//                   to the syntax. In the case of the example:
-//                   PIECE_MOVE_FILE
+// san_lex_length(): Like san_lex(), but lexes the first length
+//                   characters of input, which does not need to be
+//                   '\0' terminated.
 /////////////////////////////////////////////////////////////////////
-//san_type san_type_piece(const char *input);
+San_move san_lex_length(const char *input, int length);
 
 /////////////////////////////////////////////////////////////////////
-// san_type_castle(): Checks if string is in syntactically correct
-//                    format for a san casteling move.
-//                    Returns CASTLE_LEFT, CASTLE_RIGHT or
-//                    INVALID_SAN.
+// get_san_type(): Returns only the type found by san_lex().
 /////////////////////////////////////////////////////////////////////
-//san_type san_type_castle(const char *input);
-
+san_type get_san_type(const char *input);
 
 #endif // SAN_PARSING_H
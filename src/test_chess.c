@@ -13,10 +13,16 @@
 #define TEST_CORE_FUNCTIONS_H
 #define TEST_CORE_INTERFACE_H
 #define TEST_DS_LIB_H
+#define TEST_MEM_UTILITIES_H
 #define TEST_TUI_LIB_H
 #define TEST_GRAPHIC_OUTPUT_H
 #define TEST_INPUT_H
 #define TEST_SAN_PARSING_H
+#define TEST_PGN_PARSING_H
+#define TEST_OPENING_BOOK_H
+#define TEST_BITBASE_H
+#define TEST_EVALUATION_H
+#define TEST_NNUE_H
 
 /* include directives */
 #include "test-framework/unity/unity.h"
@@ -28,12 +34,24 @@
 #include "core_functions.h"
 #include "core_interface.h"
 #include "ds_lib.h"
+#include "mem_utilities.h"
 #include "tui_lib.h"
 #include "input.h"
 #include "san_parsing.h"
+#include "pgn_parsing.h"
+#include "zobrist.h"
+#include "opening_book.h"
+#include "bitbase.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 void setUp (void) {} /* Is run before every test, put unit init calls here. */
 void tearDown (void) {} /* Is run after every test, put unit clean-up calls here. */
@@ -1677,6 +1695,113 @@ void test_upgrade_pawn_01(void)
 
     free(game);
 }
+
+void test_san_to_move_01(void)
+{
+    Game game = create_game();
+    Move move = san_to_move("e4", game);
+
+    TEST_ASSERT_TRUE((1 == move.from.row) && (4 == move.from.column)
+                  && (3 == move.to.row) && (4 == move.to.column));
+
+    destroy_game(game);
+}
+
+void test_san_to_move_02(void)
+{
+    Game game = create_game();
+    Move move = san_to_move("Nf3", game);
+
+    TEST_ASSERT_TRUE((0 == move.from.row) && (6 == move.from.column)
+                  && (2 == move.to.row) && (5 == move.to.column));
+
+    destroy_game(game);
+}
+
+void test_san_to_move_03_illegal(void)
+{
+    Game game = create_game();
+    Move move = san_to_move("e5", game);
+
+    TEST_ASSERT_TRUE((-1 == move.from.row) && (1 == move.to.row));
+
+    destroy_game(game);
+}
+
+void test_san_to_move_04_ambiguous(void)
+{
+    Game game = create_game();
+    set_game_state(access_state(game), "k......."
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       ".N..KN..");
+    Move move = san_to_move("Nd2", game);
+
+    TEST_ASSERT_TRUE((-1 == move.from.row) && (0 == move.to.row));
+
+    destroy_game(game);
+}
+
+void test_san_to_move_05_disambiguation(void)
+{
+    Game game = create_game();
+    set_game_state(access_state(game), "k......."
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       ".N..KN..");
+    Move move = san_to_move("Nbd2", game);
+
+    TEST_ASSERT_TRUE((0 == move.from.row) && (1 == move.from.column)
+                  && (1 == move.to.row) && (3 == move.to.column));
+
+    destroy_game(game);
+}
+
+void test_san_to_move_06_castle(void)
+{
+    Game game = create_game();
+    set_game_state(access_state(game), "k......."
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "....K..R");
+    Move move = san_to_move("O-O", game);
+
+    TEST_ASSERT_TRUE((0 == move.from.row) && (4 == move.from.column)
+                  && (0 == move.to.row) && (6 == move.to.column));
+
+    destroy_game(game);
+}
+
+void test_san_to_move_07_promotion_check(void)
+{
+    Game game = create_game();
+    set_game_state(access_state(game), "k......."
+                                       "....P..."
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "K.......");
+    Move move = san_to_move("e8=Q+", game);
+
+    TEST_ASSERT_TRUE((6 == move.from.row) && (4 == move.from.column)
+                  && (7 == move.to.row) && (4 == move.to.column));
+
+    destroy_game(game);
+}
 #endif
 
 //////////////
@@ -1743,6 +1868,248 @@ void test_stack_int_pop_02(void)
     TEST_ASSERT_TRUE(5 == n);
     stack_int_destroy(stack);
 }
+
+void test_stack_int_many_01(void)
+{
+    Stack_int stack = stack_int_create();
+    int values[1000];
+    for (int i = 0; i < 1000; i++)
+        values[i] = i;
+    stack_int_push_many(stack, values, 1000);
+    stack_int_push(stack, 1000);
+
+    int top[3];
+    int n;
+    TEST_ASSERT_EQUAL_INT(3, stack_int_pop_many(stack, top, 3));
+    TEST_ASSERT_TRUE((1000 == top[0]) && (999 == top[1]) && (998 == top[2]));
+    TEST_ASSERT_EQUAL_INT(998, stack_int_pop_many(stack, values, 2000));
+    TEST_ASSERT_TRUE((996 == values[1]) && (0 == values[997]));
+    TEST_ASSERT_TRUE(stack_int_is_empty(stack) && !stack_int_pop(stack, &n));
+    stack_int_destroy(stack);
+}
+
+void test_stack_int_reserve_01(void)
+{
+    Stack_int stack = stack_int_create();
+    TEST_ASSERT_TRUE(stack_int_is_full(stack));
+    TEST_ASSERT_TRUE(stack_int_reserve(stack, 3) && !stack_int_reserve(stack, -1));
+    stack_int_push(stack, 1);
+    stack_int_push(stack, 2);
+    TEST_ASSERT_TRUE(!stack_int_is_full(stack));
+    stack_int_push(stack, 3);
+    TEST_ASSERT_TRUE(stack_int_is_full(stack));
+    stack_int_push(stack, 4);
+    TEST_ASSERT_TRUE(!stack_int_is_full(stack));
+    stack_int_shrink_to_fit(stack);
+    TEST_ASSERT_TRUE(stack_int_is_full(stack) && (4 == stack_int_size(stack)));
+
+    int n;
+    stack_int_make_empty(stack);
+    stack_int_shrink_to_fit(stack);
+    TEST_ASSERT_TRUE(stack_int_is_empty(stack) && !stack_int_peek(stack, &n));
+    stack_int_push(stack, 5);
+    TEST_ASSERT_TRUE(stack_int_peek(stack, &n) && (5 == n));
+    stack_int_destroy(stack);
+}
+
+STACK_DECLARE(Stack_move, stack_move, Move_i)
+STACK_DEFINE(Stack_move, stack_move, Move_i)
+
+void test_stack_typed_01(void)
+{
+    Stack_move stack = stack_move_create();
+    stack_move_push(stack, (Move_i) {{1, 4}, {3, 4}});
+    stack_move_push(stack, (Move_i) {{6, 4}, {4, 4}});
+
+    Move_i move;
+    TEST_ASSERT_TRUE(stack_move_pop(stack, &move) && (6 == move.from.row) && (4 == move.to.row));
+    TEST_ASSERT_TRUE(stack_move_pop(stack, &move) && (1 == move.from.row) && (3 == move.to.row));
+    TEST_ASSERT_TRUE(!stack_move_pop(stack, &move));
+    stack_move_destroy(stack);
+}
+#endif
+
+/////////////////////
+// mem_utilities.h //
+/////////////////////
+#ifdef TEST_MEM_UTILITIES_H
+void test_pool_01_reuse(void)
+{
+    Pool pool = pool_create(24, POOL_POISON);
+    void *objects[100];
+    for (int i = 0; i < 100; i++)
+        objects[i] = pool_alloc(pool);
+
+    bool aligned = true;
+    bool distinct = true;
+    for (int i = 0; i < 100; i++)
+    {
+        aligned = aligned && (0 == (uintptr_t) objects[i] % _Alignof(max_align_t));
+        for (int j = 0; j < i; j++)
+            distinct = distinct && (objects[i] != objects[j]);
+    }
+    long used, capacity;
+    pool_statistics(pool, &used, &capacity);
+    TEST_ASSERT_TRUE(aligned && distinct && (100 == used) && (100 <= capacity));
+
+    // freed objects are used again, the last one first
+    pool_free(pool, objects[10]);
+    pool_free(pool, objects[20]);
+    TEST_ASSERT_TRUE(objects[20] == pool_alloc(pool));
+    TEST_ASSERT_TRUE(objects[10] == pool_alloc(pool));
+    TEST_ASSERT_EQUAL_HEX8(POOL_FRESH_BYTE, ((unsigned char *) objects[10])[23]);
+
+    pool_destroy(pool);
+}
+
+// helper: allocates and frees objects of the pool in argument,
+//         checking that no other thread got the same objects
+static void *use_pool(void *argument)
+{
+    Pool pool = argument;
+    long *objects[64];
+    long mark = (long) pthread_self();
+    bool intact = true;
+    for (int round = 0; round < 200; round++)
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            objects[i] = pool_alloc(pool);
+            *objects[i] = mark + i;
+        }
+        for (int i = 0; i < 64; i++)
+        {
+            intact = intact && (mark + i == *objects[i]);
+            pool_free(pool, objects[i]);
+        }
+    }
+    return intact ? pool : NULL;
+}
+
+void test_pool_02_threads(void)
+{
+    Pool pool = pool_create(sizeof(long), POOL_THREADS);
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++)
+        pthread_create(&threads[t], NULL, use_pool, pool);
+    bool intact = true;
+    for (int t = 0; t < 4; t++)
+    {
+        void *result;
+        pthread_join(threads[t], &result);
+        intact = intact && (NULL != result);
+    }
+
+    // the caches went back to the pool when the threads exited
+    long used, capacity;
+    pool_statistics(pool, &used, &capacity);
+    TEST_ASSERT_TRUE(intact);
+    TEST_ASSERT_EQUAL_INT64(0, used);
+    pool_destroy(pool);
+
+    // a thread alternating between pools keeps a cache for each
+    Pool pools[17];
+    for (int i = 0; i < 17; i++)
+        pools[i] = pool_create(sizeof(long), POOL_THREADS);
+    for (int i = 0; i < 100000; i++)
+    {
+        Pool alternating = pools[(i % 2) ? 16 : 0];
+        pool_free(alternating, pool_alloc(alternating));
+    }
+    pool_statistics(pools[0], &used, &capacity);
+    TEST_ASSERT_TRUE(capacity <= POOL_CACHE_SIZE);
+    pool_statistics(pools[16], &used, &capacity);
+    TEST_ASSERT_TRUE(capacity <= POOL_CACHE_SIZE);
+    for (int i = 0; i < 17; i++)
+        pool_destroy(pools[i]);
+}
+
+void test_mem_01_statistics(void)
+{
+    Mem_statistics before, after;
+    mem_statistics(MEM_GENERAL, &before);
+    char *bytes = mem_alloc(MEM_GENERAL, 100);
+    bytes = mem_realloc(MEM_GENERAL, bytes, 100, 300);
+    bytes = mem_realloc(MEM_GENERAL, bytes, 300, 50);
+    mem_statistics(MEM_GENERAL, &after);
+    TEST_ASSERT_EQUAL_INT64(before.bytes_live + 50, after.bytes_live);
+    TEST_ASSERT_TRUE(after.bytes_peak >= before.bytes_live + 300);
+    TEST_ASSERT_EQUAL_INT64(before.bytes_total + 300, after.bytes_total);
+    TEST_ASSERT_EQUAL_INT64(before.allocations + 1, after.allocations);
+    TEST_ASSERT_EQUAL_INT64(before.reallocations + 2, after.reallocations);
+    mem_free(MEM_GENERAL, bytes, 50);
+    mem_statistics(MEM_GENERAL, &after);
+    TEST_ASSERT_EQUAL_INT64(before.bytes_live, after.bytes_live);
+    TEST_ASSERT_EQUAL_INT64(before.frees + 1, after.frees);
+
+    // stacks and input readers are counted as MEM_GENERAL
+    mem_statistics(MEM_GENERAL, &before);
+    Stack_int stack = stack_int_create();
+    for (int i = 0; i < 100; i++)
+        stack_int_push(stack, i);
+    stack_int_shrink_to_fit(stack);
+    Input_reader reader = input_reader_create(STDIN_FILENO);
+    mem_statistics(MEM_GENERAL, &after);
+    TEST_ASSERT_TRUE(after.bytes_live >= before.bytes_live + 100 * (long) sizeof(int));
+    stack_int_destroy(stack);
+    input_reader_destroy(reader);
+    mem_statistics(MEM_GENERAL, &after);
+    TEST_ASSERT_EQUAL_INT64(before.bytes_live, after.bytes_live);
+
+    // the history of a game is counted as MEM_GAME_STATE
+    mem_statistics(MEM_GAME_STATE, &before);
+    Game game = create_game();
+    move_piece(game, (Move) { (Square) {1,3}, (Square) {3,3} });
+    move_piece(game, (Move) { (Square) {6,3}, (Square) {4,3} });
+    mem_statistics(MEM_GAME_STATE, &after);
+    TEST_ASSERT_TRUE(after.bytes_live >= before.bytes_live + 3 * (long) sizeof(Game_state));
+    destroy_game(game);
+    mem_statistics(MEM_GAME_STATE, &after);
+    TEST_ASSERT_EQUAL_INT64(before.bytes_live, after.bytes_live);
+}
+
+// helper: backend counting its calls in context, failing every
+//         allocation once context[0] reached context[3]
+static void *counting_alloc(void *context, size_t size)
+{
+    long *calls = context;
+    if (calls[0] >= calls[3])
+        return NULL;
+    calls[0]++;
+    return malloc(size);
+}
+
+static void *counting_realloc(void *context, void *pointer, size_t old_size, size_t size)
+{
+    (void) old_size;
+    ((long *) context)[1]++;
+    return realloc(pointer, size);
+}
+
+static void counting_free(void *context, void *pointer, size_t size)
+{
+    (void) size;
+    ((long *) context)[2]++;
+    free(pointer);
+}
+
+void test_mem_02_backend(void)
+{
+    long calls[4] = {0, 0, 0, 2};
+    Mem_backend backend = {counting_alloc, counting_realloc, counting_free, calls};
+    mem_set_backend(&backend);
+
+    Pool pool = pool_create(sizeof(long), 0);
+    pool_free(pool, pool_alloc(pool));
+    void *failed = mem_try_alloc(MEM_GENERAL, 10);
+    pool_destroy(pool);
+
+    mem_set_backend(NULL);
+    TEST_ASSERT_NULL(failed);
+    TEST_ASSERT_EQUAL_INT64(2, calls[0]);
+    TEST_ASSERT_EQUAL_INT64(0, calls[1]);
+    TEST_ASSERT_EQUAL_INT64(2, calls[2]);
+}
 #endif
 
 #ifdef TEST_TUI_LIB_H
@@ -1775,6 +2142,57 @@ void test_screen_create_01(void)
     free(ids_s1);
 }
 
+// helper: creates 200 windows and writes them to argument
+static void *create_windows(void *argument)
+{
+    Window *windows = argument;
+    for (int i = 0; i < 200; i++)
+        windows[i] = window_create();
+    return NULL;
+}
+
+// helper: destroys the 200 windows in argument
+static void *destroy_windows(void *argument)
+{
+    Window *windows = argument;
+    for (int i = 0; i < 200; i++)
+        window_destroy(windows[i]);
+    return NULL;
+}
+
+static int compare_ids(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+void test_window_create_02_threads(void)
+{
+    static Window windows[4][200];
+    pthread_t threads[4];
+    int ids[800];
+
+    for (int t = 0; t < 4; t++)
+        pthread_create(&threads[t], NULL, create_windows, windows[t]);
+    for (int t = 0; t < 4; t++)
+        pthread_join(threads[t], NULL);
+    for (int i = 0; i < 800; i++)
+        ids[i] = window_id(windows[i / 200][i % 200]);
+    qsort(ids, 800, sizeof(*ids), compare_ids);
+    bool unique = (0 < ids[0]);
+    for (int i = 1; i < 800; i++)
+        unique = unique && (ids[i - 1] != ids[i]);
+
+    for (int t = 0; t < 4; t++)
+        pthread_create(&threads[t], NULL, destroy_windows, windows[t]);
+    for (int t = 0; t < 4; t++)
+        pthread_join(threads[t], NULL);
+
+    // the ids are used again
+    Window w1 = window_create();
+    TEST_ASSERT_TRUE(unique && (window_id(w1) <= ids[799]));
+    window_destroy(w1);
+}
+
 void test_screen_add_window_01_one_screen_one_window_01(void)
 {
     Window w1 = window_create();
@@ -2046,6 +2464,102 @@ void test_screen_remove_window_03(void)
     free(ids_w1);
 }
 
+void test_screen_add_window_21_many_windows(void)
+{
+    Screen s1 = screen_create();
+    Window windows[100];
+    for (int i = 0; i < 100; i++)
+        windows[i] = window_create();
+    for (int i = 99; i >= 0; i--)
+        screen_add_window(s1, windows[i], 3 * i);
+    for (int i = 1; i < 100; i += 2)
+        screen_remove_window(s1, windows[i]);
+
+    // raise the lowest window to the top, then let a window take an occupied priority
+    screen_add_window(s1, windows[0], 1000);
+    screen_add_window(s1, windows[2], 12);
+
+    int ids_ought[50];
+    int prios_ought[50];
+    ids_ought[0] = window_id(windows[4]);
+    prios_ought[0] = 11;
+    ids_ought[1] = window_id(windows[2]);
+    prios_ought[1] = 12;
+    for (int i = 2; i < 49; i++)
+    {
+        ids_ought[i] = window_id(windows[2 * i + 2]);
+        prios_ought[i] = 3 * (2 * i + 2);
+    }
+    ids_ought[49] = window_id(windows[0]);
+    prios_ought[49] = 1000;
+
+    int amount_ids, amount_prios;
+    int *ids = screen_windows_id(s1, &amount_ids);
+    int *prios = screen_windows_prio(s1, &amount_prios);
+
+    TEST_ASSERT_TRUE((50 == amount_ids) && (50 == amount_prios)
+                  && compare_arrays_int(ids, ids_ought, 50)
+                  && compare_arrays_int(prios, prios_ought, 50)
+                  && !screen_remove_window(s1, windows[1])
+                  && screen_remove_window(s1, windows[98]));
+
+    free(prios);
+    free(ids);
+    for (int i = 0; i < 100; i++)
+        window_destroy(windows[i]);
+    screen_destroy(s1);
+}
+
+void test_screen_add_window_22_same_priority(void)
+{
+    Screen s1 = screen_create();
+    Window windows[501];
+    for (int i = 0; i < 501; i++)
+        windows[i] = window_create();
+    // every window downgrades all windows added before it
+    for (int i = 0; i < 500; i++)
+        TEST_ASSERT_TRUE(screen_add_window(s1, windows[i], 0));
+    // a collision in the middle downgrades only the lower half
+    TEST_ASSERT_TRUE(screen_add_window(s1, windows[500], -250));
+
+    int ids_ought[501];
+    int prios_ought[501];
+    for (int i = 0; i < 250; i++)
+    {
+        ids_ought[i] = window_id(windows[i]);
+        prios_ought[i] = i - 500;
+    }
+    ids_ought[250] = window_id(windows[500]);
+    prios_ought[250] = -250;
+    for (int i = 250; i < 500; i++)
+    {
+        ids_ought[i + 1] = window_id(windows[i]);
+        prios_ought[i + 1] = i - 499;
+    }
+
+    int amount_ids, amount_prios;
+    int *ids = screen_windows_id(s1, &amount_ids);
+    int *prios = screen_windows_prio(s1, &amount_prios);
+
+    TEST_ASSERT_TRUE((501 == amount_ids) && (501 == amount_prios)
+                  && compare_arrays_int(ids, ids_ought, 501)
+                  && compare_arrays_int(prios, prios_ought, 501));
+
+    // the lowest priority can not be downgraded any further
+    Screen s2 = screen_create();
+    TEST_ASSERT_TRUE(screen_add_window(s2, windows[0], INT_MIN + 1)
+                  && screen_add_window(s2, windows[1], INT_MIN + 1)
+                  && !screen_add_window(s2, windows[2], INT_MIN + 1)
+                  && !screen_add_window(s2, windows[2], INT_MIN));
+
+    free(prios);
+    free(ids);
+    for (int i = 0; i < 501; i++)
+        window_destroy(windows[i]);
+    screen_destroy(s2);
+    screen_destroy(s1);
+}
+
 void test_window_print_01_lb_normal_and_lb_truncate_01(void)
 {
     Window w = window_create();
@@ -2100,6 +2614,394 @@ void test_screen_print_multiple_windows_01(void)
     window_destroy(w1);
     screen_destroy(s);
 }
+
+void test_screen_render_01_diff(void)
+{
+    Screen s = screen_create();
+    Window w = window_create();
+    screen_set_size(s, 3, 10);
+    window_set_size(w, 3, 10);
+    window_update_content(w, "abc", 3);
+    screen_add_window(s, w, 0);
+
+    int first_length, unchanged_length, changed_length;
+    screen_render(s, &first_length);
+    screen_render(s, &unchanged_length);
+    window_update_content(w, "abX", 3);
+    const char *changed = screen_render(s, &changed_length);
+
+    TEST_ASSERT_TRUE((3 * (6 + 10) + 6 == first_length) && (0 == unchanged_length));
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;3HX\x1b[4;1H", changed, changed_length);
+    TEST_ASSERT_EQUAL_INT(strlen("\x1b[1;3HX\x1b[4;1H"), changed_length);
+
+    window_destroy(w);
+    screen_destroy(s);
+}
+
+// helper: writes the characters of screen (of size height x width)
+//         to text, rows separated by '\n'
+static void screen_text(Screen screen, int height, int width, char *text)
+{
+    int length;
+    screen_invalidate(screen);
+    const char *p = screen_render(screen, &length);
+    // a full frame moves the cursor to every row, then writes it
+    for (int row = 0; row < height; row++)
+    {
+        p = strchr(p, 'H') + 1;
+        memcpy(text, p, width);
+        text += width;
+        p += width;
+        *text++ = (row < height - 1) ? '\n' : '\0';
+    }
+}
+
+void test_screen_render_02_dirty(void)
+{
+    Screen s = create_test_screen(4, 8, '.');
+    Window low = window_create();
+    Window high = window_create();
+    window_set_size(low, 2, 3);
+    window_set_size(high, 2, 3);
+    window_update_content(low, "aaaaaa", 6);
+    window_update_content(high, "bbbbbb", 6);
+    screen_add_window(s, low, 0);
+    screen_add_window(s, high, 1);
+    screen_window_set_position(s, high, 1, 1);
+    char text[100];
+    int length;
+
+    screen_render(s, &length);
+    screen_text(s, 4, 8, text);
+    TEST_ASSERT_EQUAL_STRING("aaa.....\n"
+                             "abbb....\n"
+                             ".bbb....\n"
+                             "........", text);
+
+    // moving uncovers the lower window, only the old and new rectangles are written
+    screen_window_set_position(s, high, 2, 5);
+    screen_render(s, &length);
+    TEST_ASSERT_TRUE(length < 4 * (6 + 8));
+    screen_text(s, 4, 8, text);
+    TEST_ASSERT_EQUAL_STRING("aaa.....\n"
+                             "aaa.....\n"
+                             ".....bbb\n"
+                             ".....bbb", text);
+
+    // raising the lower window and removing the other one
+    screen_add_window(s, low, 2);
+    screen_window_set_position(s, low, 1, 4);
+    screen_remove_window(s, high);
+    screen_text(s, 4, 8, text);
+    TEST_ASSERT_EQUAL_STRING("........\n"
+                             "....aaa.\n"
+                             "....aaa.\n"
+                             "........", text);
+
+    window_destroy(high);
+    window_destroy(low);
+    screen_destroy(s);
+}
+
+void test_screen_render_03_off_screen(void)
+{
+    Screen s = create_test_screen(3, 4, '.');
+    Window far = window_create();
+    Window partly = window_create();
+    window_set_size(far, 3, 3);
+    window_set_size(partly, 2, 2);
+    window_update_content(far, "fffffffff", 9);
+    window_update_content(partly, "pppp", 4);
+    screen_add_window(s, far, 1);
+    screen_add_window(s, partly, 0);
+    screen_window_set_position(s, far, INT_MAX - 1, INT_MAX - 1);
+    screen_window_set_position(s, partly, -1, -1);
+    char text[100];
+
+    screen_text(s, 3, 4, text);
+    TEST_ASSERT_EQUAL_STRING("p...\n"
+                             "....\n"
+                             "....", text);
+
+    screen_window_set_position(s, far, INT_MIN, 2);
+    screen_window_set_position(s, partly, 2, 3);
+    screen_text(s, 3, 4, text);
+    TEST_ASSERT_EQUAL_STRING("....\n"
+                             "....\n"
+                             "...p", text);
+
+    window_destroy(partly);
+    window_destroy(far);
+    screen_destroy(s);
+}
+
+void test_screen_render_04_shared_window(void)
+{
+    Screen s1 = create_test_screen(3, 4, '.');
+    Screen s2 = create_test_screen(3, 6, '.');
+    Window shared = window_create();
+    window_set_size(shared, 1, 2);
+    window_update_content(shared, "ab", 2);
+    screen_add_window(s1, shared, 0);
+    screen_add_window(s2, shared, 0);
+    screen_window_set_position(s2, shared, 2, 4);
+    char text[100];
+    int length;
+    screen_render(s1, &length);
+    screen_render(s2, &length);
+
+    // both screens get notified and only write the window
+    window_update_content(shared, "cd", 2);
+    const char *output = screen_render(s1, &length);
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;1Hcd\x1b[4;1H", output, length);
+    output = screen_render(s2, &length);
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[3;5Hcd\x1b[4;1H", output, length);
+
+    // growing the window marks the new rectangle as well
+    window_set_size(shared, 2, 2);
+    window_update_content(shared, "cdef", 4);
+    screen_text(s1, 3, 4, text);
+    TEST_ASSERT_EQUAL_STRING("cd..\n"
+                             "ef..\n"
+                             "....", text);
+    screen_text(s2, 3, 6, text);
+    TEST_ASSERT_EQUAL_STRING("......\n"
+                             "......\n"
+                             "....cd", text);
+
+    window_destroy(shared);
+    screen_text(s1, 3, 4, text);
+    TEST_ASSERT_EQUAL_STRING("....\n"
+                             "....\n"
+                             "....", text);
+
+    screen_destroy(s2);
+    screen_destroy(s1);
+}
+
+void test_screen_render_07_cells(void)
+{
+    Screen s = create_test_screen(1, 4, '.');
+    Window w = window_create();
+    window_set_size(w, 1, 4);
+    screen_add_window(s, w, 0);
+    int length;
+    const char *output;
+
+    // one cell per code point, invalid bytes become U+FFFD
+    window_update_content(w, "\xe2\x99\x94" "a\xff", 5);
+    output = screen_render(s, &length);
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;1H\xe2\x99\x94" "a\xef\xbf\xbd \x1b[2;1H", output, length);
+
+    // runs of one style share an SGR sequence, cells of style 0 take
+    // the style of the window, every frame ends with the defaults
+    Cell cells[] = {{'x', TUI_STYLE(TUI_RED, TUI_DEFAULT, TUI_BOLD)},
+                    {'y', TUI_STYLE(TUI_RED, TUI_DEFAULT, TUI_BOLD)},
+                    {'z', 0}, {0, 0}, {'!', 0}};
+    TEST_ASSERT_TRUE(window_set_style(w, TUI_STYLE(TUI_DEFAULT, TUI_BLUE, 0)));
+    TEST_ASSERT_TRUE(window_update_cells(w, cells, 5));
+    output = screen_render(s, &length);
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;1H\x1b[0;1;31mxy\x1b[0;44mz \x1b[0m\x1b[2;1H", output, length);
+
+    // a new style alone changes a cell
+    window_set_style(w, TUI_STYLE(TUI_BRIGHT + TUI_GREEN, 200, TUI_UNDERLINE));
+    output = screen_render(s, &length);
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;3H\x1b[0;4;92;48;5;200mz \x1b[0m\x1b[2;1H", output, length);
+
+    TEST_ASSERT_FALSE(window_set_style(w, TUI_STYLE(300, TUI_DEFAULT, 0)));
+    TEST_ASSERT_FALSE(window_set_style(w, 1u << 24));
+    TEST_ASSERT_FALSE(window_update_cells(w, cells, -1));
+
+    window_destroy(w);
+    screen_destroy(s);
+}
+
+void test_screen_render_06_scrollback(void)
+{
+    Screen s = create_test_screen(3, 6, '.');
+    Window w = window_create();
+    window_set_size(w, 3, 6);
+    screen_add_window(s, w, 0);
+    char text[100];
+
+    TEST_ASSERT_FALSE(window_append(w, "one\n", 4));
+    TEST_ASSERT_TRUE(window_set_scrollback(w, 4));
+    window_append(w, "one\ntwo\nthr", 11);
+    screen_text(s, 3, 6, text);
+    TEST_ASSERT_EQUAL_STRING("one   \n"
+                             "two   \n"
+                             "thr   ", text);
+
+    // the oldest line is dropped
+    window_append(w, "ee\nfour\nfive\n", 13);
+    screen_text(s, 3, 6, text);
+    TEST_ASSERT_EQUAL_STRING("three \n"
+                             "four  \n"
+                             "five  ", text);
+
+    window_scroll(w, 1);
+    screen_text(s, 3, 6, text);
+    TEST_ASSERT_EQUAL_STRING("two   \n"
+                             "three \n"
+                             "four  ", text);
+
+    // without following the view stays on the same lines
+    window_follow_tail(w, false);
+    window_append(w, "six\n", 4);
+    screen_text(s, 3, 6, text);
+    TEST_ASSERT_EQUAL_STRING("three \n"
+                             "four  \n"
+                             "      ", text);
+
+    // the newest line is broken, its bottom part shown
+    window_follow_tail(w, true);
+    window_append(w, "abcdefghij", 10);
+    screen_text(s, 3, 6, text);
+    TEST_ASSERT_EQUAL_STRING("six   \n"
+                             "abcdef\n"
+                             "ghij  ", text);
+
+    // once every slot of the ring has memory, appending reuses it
+    Mem_statistics before, after;
+    int length;
+    window_append(w, "\n1\n2\n3\n4\n", 9);
+    screen_render(s, &length);
+    mem_statistics(MEM_TUI, &before);
+    for (int i = 0; i < 1000; i++)
+    {
+        window_append(w, "line\n", 5);
+        screen_render(s, &length);
+    }
+    mem_statistics(MEM_TUI, &after);
+    TEST_ASSERT_EQUAL_INT64(before.allocations + before.reallocations, after.allocations + after.reallocations);
+
+    window_destroy(w);
+    screen_destroy(s);
+}
+
+void test_screen_render_05_lb_smart_and_orientation(void)
+{
+    Screen s = create_test_screen(3, 8, '.');
+    Window w = window_create();
+    window_set_size(w, 3, 8);
+    window_set_linebreak(w, LB_SMART);
+    window_update_content(w, "one two three\nxy", 16);
+    screen_add_window(s, w, 0);
+    char text[100];
+
+    screen_text(s, 3, 8, text);
+    TEST_ASSERT_EQUAL_STRING("one two \n"
+                             "three   \n"
+                             "xy      ", text);
+
+    window_set_orientation(w, RIGHT);
+    screen_text(s, 3, 8, text);
+    TEST_ASSERT_EQUAL_STRING(" one two\n"
+                             "   three\n"
+                             "      xy", text);
+
+    // narrower than the longest line, so the lines are broken again,
+    // words longer than the window are cut
+    window_set_orientation(w, CENTER);
+    window_set_size(w, 3, 4);
+    screen_text(s, 3, 8, text);
+    TEST_ASSERT_EQUAL_STRING("one ....\n"
+                             "two ....\n"
+                             "thre....", text);
+
+    window_set_linebreak(w, LB_TRUNCATE);
+    screen_text(s, 3, 8, text);
+    TEST_ASSERT_EQUAL_STRING("one ....\n"
+                             " xy ....\n"
+                             "    ....", text);
+
+    window_destroy(w);
+    screen_destroy(s);
+}
+
+void test_renderer_01_publish(void)
+{
+    Screen s = screen_create();
+    Window w = window_create();
+    screen_set_size(s, 3, 10);
+    window_set_size(w, 3, 10);
+    window_update_content(w, "abc", 3);
+    screen_add_window(s, w, 0);
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    Renderer renderer = renderer_create(fds[1]);
+    TEST_ASSERT_NOT_NULL(renderer);
+    char output[1000];
+
+    renderer_publish(renderer, s);
+    renderer_flush(renderer);
+    TEST_ASSERT_EQUAL_INT(3 * (6 + 10) + 6, read(fds[0], output, sizeof(output)));
+
+    // the second frame is either written as an empty diff or coalesced
+    window_update_content(w, "abX", 3);
+    renderer_publish(renderer, s);
+    renderer_publish(renderer, s);
+    renderer_flush(renderer);
+    ssize_t length = read(fds[0], output, sizeof(output));
+    TEST_ASSERT_EQUAL_INT(strlen("\x1b[1;3HX\x1b[4;1H"), length);
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;3HX\x1b[4;1H", output, length);
+
+    long published, written;
+    renderer_statistics(renderer, &published, &written);
+    TEST_ASSERT_EQUAL_INT(3, published);
+    TEST_ASSERT_TRUE((2 <= written) && (written <= 3));
+
+    renderer_destroy(renderer);
+    close(fds[1]);
+    close(fds[0]);
+    window_destroy(w);
+    screen_destroy(s);
+}
+
+void test_renderer_02_mixed_with_screen_render(void)
+{
+    Screen s = screen_create();
+    Window w = window_create();
+    screen_set_size(s, 1, 4);
+    window_set_size(w, 1, 4);
+    window_update_content(w, "ab", 2);
+    screen_add_window(s, w, 0);
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    char output[1000];
+    int length;
+    screen_render(s, &length);
+
+    // the renderer composites the change before screen_render() sees it
+    window_update_content(w, "cd", 2);
+    Renderer renderer = renderer_create(fds[1]);
+    TEST_ASSERT_NOT_NULL(renderer);
+    renderer_publish(renderer, s);
+    renderer_flush(renderer);
+    renderer_destroy(renderer);
+    TEST_ASSERT_EQUAL_INT(6 + 4 + 6, read(fds[0], output, sizeof(output)));
+
+    const char *rendered = screen_render(s, &length);
+    TEST_ASSERT_EQUAL_INT(strlen("\x1b[1;1Hcd\x1b[2;1H"), length);
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;1Hcd\x1b[2;1H", rendered, length);
+    screen_render(s, &length);
+    TEST_ASSERT_EQUAL_INT(0, length);
+
+    // and the other way round
+    window_update_content(w, "ef", 2);
+    screen_render(s, &length);
+    renderer = renderer_create(fds[1]);
+    renderer_publish(renderer, s);
+    renderer_flush(renderer);
+    renderer_destroy(renderer);
+    TEST_ASSERT_EQUAL_INT(6 + 4 + 6, read(fds[0], output, sizeof(output)));
+    TEST_ASSERT_EQUAL_STRING_LEN("\x1b[1;1Hef", output, 8);
+
+    close(fds[1]);
+    close(fds[0]);
+    window_destroy(w);
+    screen_destroy(s);
+}
 #endif
 
 #ifdef TEST_GRAPHIC_OUTPUT_H
@@ -2146,6 +3048,63 @@ void test_board_window_01(void)
     screen_destroy(s);
 }
 
+void test_write_current_board_03_incremental(void)
+{
+    // with captures, castling and a pawn upgraded to a queen
+    const Move moves[] = {{{1, 4}, {3, 4}}, {{6, 3}, {4, 3}}, {{3, 4}, {4, 3}}, {{6, 2}, {5, 2}},
+                          {{4, 3}, {5, 2}}, {{7, 6}, {5, 5}}, {{5, 2}, {6, 1}}, {{6, 4}, {5, 4}},
+                          {{6, 1}, {7, 0}}, {{7, 5}, {6, 4}}, {{0, 6}, {2, 5}}, {{7, 4}, {7, 6}},
+                          {{0, 5}, {3, 2}}, {{7, 1}, {5, 2}}, {{0, 4}, {0, 6}}};
+    Game game = create_game();
+    char white[BOARD_TEXT_LENGTH + 1];
+    char black[BOARD_TEXT_LENGTH + 1];
+    char expected[BOARD_TEXT_LENGTH + 1];
+    static Cell cells[BOARD_TEXT_LENGTH + 1];
+
+    // the changes of a new game are not known, so all is written
+    memset(white, 'x', sizeof(white));
+    update_current_board(white, game, WHITE);
+    write_current_board(expected, game, WHITE);
+    TEST_ASSERT_EQUAL_STRING(expected, white);
+    TEST_ASSERT_EQUAL_INT(BOARD_TEXT_LENGTH, strlen(white));
+    write_current_board(black, game, BLACK);
+    write_current_board_cells(cells, game, BLACK);
+
+    for (unsigned i = 0; i < sizeof(moves) / sizeof(*moves); i++)
+    {
+        TEST_ASSERT_TRUE(move_piece(game, moves[i]));
+        if (-1 != pawn_upgradable(game).row)
+            upgrade_pawn(game, 'Q');
+
+        update_current_board(white, game, WHITE);
+        write_current_board(expected, game, WHITE);
+        TEST_ASSERT_EQUAL_STRING(expected, white);
+
+        update_current_board(black, game, BLACK);
+        update_current_board_cells(cells, game, BLACK);
+        write_current_board(expected, game, BLACK);
+        TEST_ASSERT_EQUAL_STRING(expected, black);
+        for (int j = 0; j <= BOARD_TEXT_LENGTH; j++)
+            TEST_ASSERT_EQUAL_UINT32((unsigned char) expected[j], cells[j].codepoint);
+    }
+
+    // castling changes the squares of the king and the rook
+    Square squares[GAME_STATE_CHANGES];
+    TEST_ASSERT_EQUAL_INT(4, last_changes(game, squares));
+
+    // from black's side the first rank and the h-file are at the top left
+    TEST_ASSERT_EQUAL_STRING_LEN("     h     g     f     e     d     c     b     a  \n", black, 51);
+    TEST_ASSERT_EQUAL_STRING_LEN("1 |     |  K  |  R  |     |  Q  |  B  |  N  |  R  | 1\n", black + 157, 54);
+    TEST_ASSERT_EQUAL_STRING_LEN("8 |  Q  |     |  b  |  q  |     |  r  |  k  |     | 8\n", white + 157, 54);
+
+    Window w = window_create();
+    window_set_size(w, 30, 53);
+    TEST_ASSERT_TRUE(window_update_cells(w, cells, BOARD_TEXT_LENGTH + 1));
+    window_destroy(w);
+
+    destroy_game(game);
+}
+
 #endif
 
 #ifdef TEST_INPUT_H
@@ -2158,6 +3117,52 @@ void test_read_input(void)
     TEST_ASSERT_TRUE(true);
     free(line);
 }
+
+void test_input_reader_01(void)
+{
+    int fds[2];
+    TEST_ASSERT_TRUE(0 == pipe(fds));
+    char text[] = "e4\r\ne5\n\nNf3";
+    TEST_ASSERT_TRUE((ssize_t) strlen(text) == write(fds[1], text, strlen(text)));
+    close(fds[1]);
+
+    Input_reader reader = input_reader_create(fds[0]);
+    Input_line lines[4];
+    bool read[5];
+    for (int i = 0; i < 4; i++)
+        read[i] = input_reader_next_line(reader, &lines[i]);
+    read[4] = input_reader_next_line(reader, &lines[0]);
+
+    // a line view is only valid until the next call, the last one is still valid
+    TEST_ASSERT_TRUE(read[0] && read[1] && read[2] && read[3] && !read[4]
+                  && (0 == lines[2].length) && (3 == lines[3].length)
+                  && (0 == strcmp("Nf3", lines[3].text)));
+
+    input_reader_destroy(reader);
+    close(fds[0]);
+}
+
+void test_input_reader_02_long_line(void)
+{
+    FILE *file = tmpfile();
+    for (int i = 0; i < 200000; i++)
+        fputc('a' + i % 26, file);
+    fputs("\nlast\n", file);
+    fflush(file);
+    rewind(file);
+
+    Input_reader reader = input_reader_create(fileno(file));
+    Input_line line;
+    input_reader_next_line(reader, &line);
+    bool long_line_ok = (200000 == line.length) && ('a' == line.text[0]) && ('a' + 199999 % 26 == line.text[199999]);
+    input_reader_next_line(reader, &line);
+
+    TEST_ASSERT_TRUE(long_line_ok && (0 == strcmp("last", line.text))
+                  && !input_reader_next_line(reader, &line) && input_reader_eof(reader));
+
+    input_reader_destroy(reader);
+    fclose(file);
+}
 #endif
 
 #ifdef TEST_SAN_PARSING_H
@@ -2385,6 +3390,593 @@ void test_get_san_type_invalid_02(void)
     TEST_ASSERT_EQUAL_INT(INVALID_SAN, get_san_type(test_string));
 }
 
+void test_san_lex_01_piece(void)
+{
+    San_move move = san_lex("Nbxd7+");
+    TEST_ASSERT_TRUE((PIECE_CAPTURE_FILE == move.type) && ('N' == move.piece)
+                  && (1 == move.from_file) && (-1 == move.from_rank)
+                  && (3 == move.to_file) && (6 == move.to_rank)
+                  && move.capture && ('+' == move.suffix));
+}
+
+void test_san_lex_02_pawn_promotion(void)
+{
+    San_move move = san_lex("dxe1=N#");
+    TEST_ASSERT_TRUE((PAWN_CAPTURE_PROMOTE == move.type) && ('P' == move.piece)
+                  && (3 == move.from_file) && (4 == move.to_file) && (0 == move.to_rank)
+                  && ('N' == move.promotion) && ('#' == move.suffix));
+}
+
+void test_san_lex_03_both(void)
+{
+    San_move move = san_lex("Qh4e1!?");
+    TEST_ASSERT_TRUE((PIECE_MOVE_BOTH == move.type) && (7 == move.from_file) && (3 == move.from_rank)
+                  && (4 == move.to_file) && (0 == move.to_rank) && !move.capture);
+}
+
+void test_san_lex_04_castle(void)
+{
+    TEST_ASSERT_EQUAL_INT(CASTLE_LEFT, san_lex("O-O-O+").type);
+}
+
+void test_san_lex_invalid_05(void)
+{
+    TEST_ASSERT_EQUAL_INT(INVALID_SAN, san_lex("e8=K").type);
+}
+
+void test_san_lex_invalid_06(void)
+{
+    TEST_ASSERT_EQUAL_INT(INVALID_SAN, san_lex("Nf3+!!?").type);
+}
+
+#endif
+
+#ifdef TEST_PGN_PARSING_H
+void test_pgn_scan_01(void)
+{
+    char movetext[] = "1. e4 e5 2.Nf3 {best by test} Nc6 $1 (2... d6) 1-0";
+    Pgn_token tokens[20];
+    int scanned;
+    int tokens_number = pgn_scan(movetext, strlen(movetext), tokens, 20, &scanned);
+
+    pgn_token_type types_ought[13] = { PGN_MOVE_NUMBER, PGN_SAN, PGN_SAN, PGN_MOVE_NUMBER, PGN_SAN, PGN_COMMENT,
+                                       PGN_SAN, PGN_NAG, PGN_VARIATION_START, PGN_MOVE_NUMBER, PGN_SAN,
+                                       PGN_VARIATION_END, PGN_RESULT };
+    bool types_equal = true;
+    for (int i = 0; i < 13; i++)
+        types_equal = types_equal && (types_ought[i] == tokens[i].type);
+
+    TEST_ASSERT_TRUE((13 == tokens_number) && types_equal && ((int) strlen(movetext) == scanned));
+}
+
+void test_pgn_scan_02_boundaries(void)
+{
+    char movetext[] = "  12...   Qxd7+ ;comment\n  O-O  ";
+    Pgn_token tokens[10];
+    int tokens_number = pgn_scan(movetext, strlen(movetext), tokens, 10, NULL);
+
+    TEST_ASSERT_TRUE((4 == tokens_number)
+                  && (2 == tokens[0].start) && (5 == tokens[0].length)
+                  && (10 == tokens[1].start) && (5 == tokens[1].length) && (PIECE_CAPTURE == tokens[1].san)
+                  && (16 == tokens[2].start) && (8 == tokens[2].length)
+                  && (27 == tokens[3].start) && (CASTLE_RIGHT == tokens[3].san));
+}
+
+void test_pgn_scan_03_continue(void)
+{
+    // long enough to use the vectorized paths
+    char movetext[] = "1. d4                                    Nf6                                    "
+                      "2. c4 e6 3. Nc3 Bb4 4. Qc2 O-O 5. a3 Bxc3+ 6. Qxc3 b6 7. Bg5 Bb7 8. f3 h6";
+    Pgn_token tokens[4];
+    int total = 0;
+    int scanned;
+    int offset = 0;
+    int length = strlen(movetext);
+    int moves = 0;
+    while (offset < length)
+    {
+        int tokens_number = pgn_scan(movetext + offset, length - offset, tokens, 4, &scanned);
+        for (int i = 0; i < tokens_number; i++)
+            moves += (PGN_SAN == tokens[i].type) && (INVALID_SAN != tokens[i].san);
+        total += tokens_number;
+        offset += scanned;
+    }
+
+    TEST_ASSERT_TRUE((24 == total) && (16 == moves));
+}
+
+void test_pgn_first_invalid_01(void)
+{
+    char movetext[] = "1. e4 e5 2. Nf3 Nz6";
+    Pgn_token tokens[10];
+    int tokens_number = pgn_scan(movetext, strlen(movetext), tokens, 10, NULL);
+
+    TEST_ASSERT_EQUAL_INT(5, pgn_first_invalid(tokens, tokens_number));
+}
+#endif
+
+#if defined(TEST_OPENING_BOOK_H) || defined(TEST_EVALUATION_H) || defined(TEST_NNUE_H)
+// helper: plays the moves given as "e2e4" strings
+static void play_moves(Game game, const char **moves, int moves_number)
+{
+    for (int i = 0; i < moves_number; i++)
+    {
+        move_piece(game, (Move) { (Square) {moves[i][1] - '1', moves[i][0] - 'a'},
+                                  (Square) {moves[i][3] - '1', moves[i][2] - 'a'} });
+    }
+}
+#endif
+
+#ifdef TEST_OPENING_BOOK_H
+// helper: writes a polyglot entry in big-endian byte order
+static void write_book_entry(FILE *file, uint64_t key, const char *move, int weight)
+{
+    int encoded = (move[3] - '1') << 3 | (move[2] - 'a') | (move[1] - '1') << 9 | (move[0] - 'a') << 6;
+    unsigned char bytes[16] = {0};
+    for (int i = 0; i < 8; i++)
+        bytes[i] = key >> (56 - 8 * i);
+    bytes[8] = encoded >> 8;
+    bytes[9] = encoded;
+    bytes[10] = weight >> 8;
+    bytes[11] = weight;
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+void test_zobrist_key_01_transposition(void)
+{
+    const char *order_1[] = {"g1f3", "g8f6", "b1c3", "b8c6"};
+    const char *order_2[] = {"b1c3", "b8c6", "g1f3", "g8f6"};
+    Game game_1 = create_game();
+    Game game_2 = create_game();
+    uint64_t start_key = position_key(game_1);
+    play_moves(game_1, order_1, 4);
+    play_moves(game_2, order_2, 4);
+
+    TEST_ASSERT_TRUE((position_key(game_1) == position_key(game_2)) && (start_key != position_key(game_1)));
+
+    destroy_game(game_1);
+    destroy_game(game_2);
+}
+
+void test_zobrist_key_02_en_passant(void)
+{
+    // the same position, but only after d7d5 black's pawn can be captured en passant
+    const char *direct[] = {"e2e4", "a7a6", "e4e5", "d7d5"};
+    const char *later[] = {"e2e4", "a7a6", "e4e5", "d7d5", "g1f3", "g8f6", "f3g1", "f6g8"};
+    Game game_1 = create_game();
+    Game game_2 = create_game();
+    play_moves(game_1, direct, 4);
+    play_moves(game_2, later, 8);
+    uint64_t key_1 = position_key(game_1);
+    uint64_t key_2 = position_key(game_2);
+
+    TEST_ASSERT_TRUE((key_1 ^ key_2) == zobrist_number(ZOBRIST_EN_PASSANT_OFFSET + 3));
+
+    destroy_game(game_1);
+    destroy_game(game_2);
+}
+
+void test_zobrist_key_03_polyglot(void)
+{
+    // keys given in the specification of the Polyglot book format
+    const char *moves[] = {"e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7"};
+    const uint64_t keys[] = {0x823C9B50FD114196ULL, 0x0756B94461C50FB0ULL, 0x662FAFB965DB29D4ULL,
+                             0x22A48B5A8E47FF78ULL, 0x652A607CA3F242C1ULL, 0x00FDD303C946BDD9ULL};
+    Game game = create_game();
+    TEST_ASSERT_EQUAL_HEX64(0x463B96181691FC9CULL, position_key(game));
+    for (int i = 0; i < 6; i++)
+    {
+        play_moves(game, &moves[i], 1);
+        TEST_ASSERT_EQUAL_HEX64(keys[i], position_key(game));
+    }
+    destroy_game(game);
+
+    const char *wing[] = {"a2a4", "b7b5", "h2h4", "b5b4", "c2c4"};
+    game = create_game();
+    play_moves(game, wing, 5);
+    TEST_ASSERT_EQUAL_HEX64(0x3C8123EA7B067637ULL, position_key(game));
+    destroy_game(game);
+}
+
+void test_book_move_01(void)
+{
+    Game game = create_game();
+    uint64_t key = position_key(game);
+    char path[] = "/tmp/chesstity_book_XXXXXX";
+    FILE *file = fdopen(mkstemp(path), "wb");
+    write_book_entry(file, key - 1, "d2d4", 50);
+    write_book_entry(file, key, "e2e5", 90);     // illegal, has to be skipped
+    write_book_entry(file, key, "d2d4", 10);
+    write_book_entry(file, key, "e2e4", 40);
+    write_book_entry(file, key + 1, "c2c4", 50);
+    fclose(file);
+
+    Opening_book book = book_open(path);
+    Book_entry entries[8];
+    Move move;
+    Letter_piece promotion = 'x';
+    int found = book_probe(book, key, entries, 8);
+    bool moved = book_move(book, game, BOOK_BEST, &move, &promotion);
+
+    TEST_ASSERT_TRUE((5 == book_entries_number(book)) && (3 == found) && (90 == entries[0].weight)
+                  && moved && (1 == move.from.row) && (4 == move.from.column)
+                  && (3 == move.to.row) && (4 == move.to.column) && ('\0' == promotion));
+
+    for (int i = 0; i < 20; i++)
+    {
+        book_move(book, game, BOOK_WEIGHTED, &move, NULL);
+        TEST_ASSERT_TRUE((1 == move.from.row) && ((3 == move.from.column) || (4 == move.from.column)));
+    }
+
+    book_close(book);
+    unlink(path);
+    destroy_game(game);
+}
+
+void test_book_move_02_castling(void)
+{
+    const char *moves[] = {"e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "f8c5"};
+    Game game = create_game();
+    play_moves(game, moves, 6);
+    char path[] = "/tmp/chesstity_book_XXXXXX";
+    FILE *file = fdopen(mkstemp(path), "wb");
+    write_book_entry(file, position_key(game), "e1h1", 1);
+    fclose(file);
+
+    Opening_book book = book_open(path);
+    Move move;
+    bool moved = book_move(book, game, BOOK_BEST, &move, NULL);
+
+    TEST_ASSERT_TRUE(moved && (0 == move.from.row) && (4 == move.from.column)
+                  && (0 == move.to.row) && (6 == move.to.column) && move_piece(game, move));
+
+    book_close(book);
+    unlink(path);
+    destroy_game(game);
+}
+#endif
+
+#ifdef TEST_BITBASE_H
+// helper: probes board with the given player to move
+static Bitbase_value probe_board(Bitbase bitbase, const char *board, Color_i to_move)
+{
+    Game game = create_game();
+    set_game_state(access_state(game), board);
+    access_state(game)->move_number = (WHITE_i == to_move) ? 1 : 2;
+    Bitbase_value value = bitbase_probe(bitbase, access_state(game));
+    destroy_game(game);
+    return value;
+}
+
+void test_bitbase_01_kqk(void)
+{
+    char path[] = "/tmp/chesstity_bitbase_XXXXXX";
+    close(mkstemp(path));
+    // the name is turned around to "KQvK"
+    bool generated = bitbase_generate("KvKQ", path, 2);
+    Bitbase bitbase = bitbase_open(path);
+
+    TEST_ASSERT_TRUE(generated && (NULL != bitbase) && (0 == strcmp("KQvK", bitbase_material(bitbase))));
+
+    // black is stalemated if it is to move
+    const char *quiet = "k......."
+                        "........"
+                        ".K......"
+                        "........"
+                        "........"
+                        "........"
+                        ".......Q"
+                        "........";
+    // black is in check
+    const char *check = "k......."
+                        "........"
+                        ".K......"
+                        "........"
+                        "........"
+                        "........"
+                        "........"
+                        ".......Q";
+    // the queen can be taken
+    const char *hanging = "k......."
+                          ".Q......"
+                          "........"
+                          "........"
+                          "........"
+                          "........"
+                          "........"
+                          ".......K";
+    // quiet with colors swapped
+    const char *mirrored = "........"
+                           ".......q"
+                           "........"
+                           "........"
+                           "........"
+                           ".k......"
+                           "........"
+                           "K.......";
+
+    TEST_ASSERT_EQUAL_INT(BITBASE_WIN, probe_board(bitbase, quiet, WHITE_i));
+    TEST_ASSERT_EQUAL_INT(BITBASE_DRAW, probe_board(bitbase, quiet, BLACK_i));
+    TEST_ASSERT_EQUAL_INT(BITBASE_LOSS, probe_board(bitbase, check, BLACK_i));
+    // white to move could take the king
+    TEST_ASSERT_EQUAL_INT(BITBASE_UNKNOWN, probe_board(bitbase, check, WHITE_i));
+    TEST_ASSERT_EQUAL_INT(BITBASE_DRAW, probe_board(bitbase, hanging, BLACK_i));
+    TEST_ASSERT_EQUAL_INT(BITBASE_WIN, probe_board(bitbase, mirrored, BLACK_i));
+    TEST_ASSERT_EQUAL_INT(BITBASE_DRAW, probe_board(bitbase, mirrored, WHITE_i));
+    // other material
+    TEST_ASSERT_EQUAL_INT(BITBASE_UNKNOWN, probe_board(bitbase, "rnbqkbnr" "pppppppp" "........" "........"
+                                                                "........" "........" "PPPPPPPP" "RNBQKBNR", WHITE_i));
+
+    bitbase_close(bitbase);
+    unlink(path);
+}
+
+void test_bitbase_02_invalid(void)
+{
+    char path[] = "/tmp/chesstity_bitbase_XXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(-1 != write(fd, "CHBB\1\3KQvK\0\0\0\0\0\0", 16));
+    close(fd);
+
+    // the header is valid, but the values are missing
+    TEST_ASSERT_NULL(bitbase_open(path));
+    TEST_ASSERT_FALSE(bitbase_generate("KQ", path, 1));
+    TEST_ASSERT_FALSE(bitbase_generate("KQQvKRR", path, 1));
+    TEST_ASSERT_FALSE(bitbase_generate("QvK", path, 1));
+
+    unlink(path);
+}
+#endif
+
+#ifdef TEST_EVALUATION_H
+void test_state_keys_01(void)
+{
+    // promotion with capture and castling on both sides
+    const char *moves[] = {"e2e4", "d7d5", "e4d5", "c7c6", "d5c6", "g8f6", "c6b7", "c8d7", "b7a8",
+                           "e7e6", "g1f3", "f8e7", "f1e2", "e8g8", "e1g1"};
+    Game game = create_game();
+    bool keys_valid = true;
+    for (int i = 0; i < 15; i++)
+    {
+        play_moves(game, &moves[i], 1);
+        if (8 == i)
+            upgrade_pawn(game, 'Q');
+        keys_valid = keys_valid && (access_state(game)->key == zobrist_key(access_state(game)))
+                                && (access_state(game)->pawn_key == zobrist_pawn_key(access_state(game)));
+    }
+
+    TEST_ASSERT_TRUE(keys_valid && (16 == access_state(game)->move_number)
+                  && (ROOK == access_state(game)->board[0][5].kind) && (ROOK == access_state(game)->board[7][5].kind));
+
+    destroy_game(game);
+}
+
+void test_evaluate_pawns_01(void)
+{
+    static const int passed[] = PAWN_PASSED;
+    Game game = create_game();
+    // a2 and a3 are doubled and isolated, a3 and h7 are isolated passed pawns
+    set_game_state(access_state(game), "....k..."
+                                       ".......p"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "P......."
+                                       "P......."
+                                       "....K...");
+    Pawn_entry entry = evaluate_pawns(access_state(game));
+
+    TEST_ASSERT_EQUAL_INT(2 * PAWN_ISOLATED + PAWN_DOUBLED + passed[2] - PAWN_ISOLATED - passed[1], entry.score);
+    TEST_ASSERT_TRUE(((1ULL << 16) == entry.passed[0]) && ((1ULL << 55) == entry.passed[1]));
+
+    // b2 is backward, c3 is passed, a4 is isolated
+    set_game_state(access_state(game), "....k..."
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "p......."
+                                       "..P....."
+                                       ".P......"
+                                       "....K...");
+    entry = evaluate_pawns(access_state(game));
+
+    TEST_ASSERT_EQUAL_INT(PAWN_BACKWARD + passed[2] - PAWN_ISOLATED, entry.score);
+
+    destroy_game(game);
+}
+
+void test_pawn_table_01(void)
+{
+    const char *moves[] = {"e2e4", "e7e5", "g1f3", "b8c6"};
+    Game game = create_game();
+    Pawn_table pawn_table = pawn_table_create(1000);
+    long hits, misses;
+
+    int start_score = evaluate(access_state(game), pawn_table);
+    play_moves(game, moves, 2);
+    evaluate(access_state(game), pawn_table);
+    // knight moves do not change the pawn structure
+    play_moves(game, &moves[2], 2);
+    int score = evaluate(access_state(game), pawn_table);
+    pawn_table_statistics(pawn_table, &hits, &misses);
+
+    TEST_ASSERT_TRUE((0 == start_score) && (evaluate(access_state(game), NULL) == score)
+                  && (2 == misses) && (1 == hits));
+
+    pawn_table_destroy(pawn_table);
+    destroy_game(game);
+}
+
+void test_eval_cache_01(void)
+{
+    // back to the start position with a different move_number
+    const char *moves[] = {"g1f3", "g8f6", "f3g1", "f6g8"};
+    Game game = create_game();
+    Eval_cache eval_cache = eval_cache_create(100);
+    long hits, misses;
+    int score;
+
+    bool empty = !eval_cache_probe(eval_cache, access_state(game)->key, &score);
+    eval_cache_store(eval_cache, 12345, -77);
+    bool stored = eval_cache_probe(eval_cache, 12345, &score) && (-77 == score);
+    eval_cache_clear(eval_cache);
+
+    int start_score = evaluate_cached(access_state(game), eval_cache, NULL);
+    play_moves(game, moves, 4);
+    int end_score = evaluate_cached(access_state(game), eval_cache, NULL);
+    eval_cache_statistics(eval_cache, &hits, &misses);
+
+    TEST_ASSERT_TRUE(empty && stored && (start_score == end_score) && (1 == hits) && (1 == misses));
+
+    eval_cache_destroy(eval_cache);
+    destroy_game(game);
+}
+
+void test_evaluate_01(void)
+{
+    Game game = create_game();
+    set_game_state(access_state(game), "....k..."
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "........"
+                                       "...QK...");
+    int white_to_move = evaluate(access_state(game), NULL);
+    access_state(game)->move_number = 2;
+    int black_to_move = evaluate(access_state(game), NULL);
+
+    TEST_ASSERT_TRUE((VALUE_QUEEN == white_to_move) && (-VALUE_QUEEN == black_to_move));
+
+    destroy_game(game);
+}
+#endif
+
+#ifdef TEST_NNUE_H
+static int16_t nnue_feature_weights[NNUE_FEATURES][NNUE_HIDDEN];
+static int16_t nnue_feature_biases[NNUE_HIDDEN];
+static int8_t nnue_output_weights[2 * NNUE_HIDDEN];
+static const int32_t nnue_output_bias = 1000;
+
+// helper: writes a network with pseudo random weights to path,
+//         which are kept in the arrays above
+static void write_network(const char *path)
+{
+    uint32_t random = 12345;
+    FILE *file = fopen(path, "wb");
+    const unsigned char header[16] = {'C', 'H', 'N', 'N', NNUE_VERSION, 0, 0, 0,
+                                      NNUE_FEATURES & 0xFF, NNUE_FEATURES >> 8, 0, 0, NNUE_HIDDEN, 0, 0, 0};
+    fwrite(header, 1, sizeof(header), file);
+    for (int i = 0; i <= NNUE_FEATURES; i++)
+    {
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+        {
+            random = random * 1103515245 + 12345;
+            int16_t weight = (int16_t) ((random >> 16) % 64) - 32;
+            // the last row are the biases, positive to keep most values above 0
+            if (NNUE_FEATURES == i)
+                nnue_feature_biases[j] = weight += 32;
+            else
+                nnue_feature_weights[i][j] = weight;
+            fputc(weight & 0xFF, file);
+            fputc((weight >> 8) & 0xFF, file);
+        }
+    }
+    for (int j = 0; j < 2 * NNUE_HIDDEN; j++)
+    {
+        random = random * 1103515245 + 12345;
+        nnue_output_weights[j] = (int8_t) ((random >> 16) % 256 - 128);
+        fputc((unsigned char) nnue_output_weights[j], file);
+    }
+    for (int i = 0; i < 4; i++)
+        fputc((nnue_output_bias >> (8 * i)) & 0xFF, file);
+    fclose(file);
+}
+
+// helper: the network of write_network() computed directly from the board
+static int reference_network(const Game_state *state)
+{
+    int32_t sum = nnue_output_bias;
+    int us = (1 == state->move_number % 2) ? 0 : 1;
+    for (int perspective = 0; perspective < 2; perspective++)
+    {
+        for (int j = 0; j < NNUE_HIDDEN; j++)
+        {
+            int32_t value = nnue_feature_biases[j];
+            for (int square = 0; square < 64; square++)
+            {
+                Piece_i piece = state->board[square / 8][square % 8];
+                if (EMPTY == piece.kind)
+                    continue;
+                int enemy = ((WHITE_i == piece.color) == (0 == perspective)) ? 0 : 1;
+                int feature = 64 * (6 * enemy + piece.kind - PAWN) + ((0 == perspective) ? square : square ^ 56);
+                value += nnue_feature_weights[feature][j];
+            }
+            value = (0 > value) ? 0 : (127 < value) ? 127 : value;
+            sum += value * nnue_output_weights[j + ((perspective == us) ? 0 : NNUE_HIDDEN)];
+        }
+    }
+    return sum / NNUE_DIVISOR;
+}
+
+void test_nnue_01_update(void)
+{
+    // promotion with capture and castling on both sides
+    const char *moves[] = {"e2e4", "d7d5", "e4d5", "c7c6", "d5c6", "g8f6", "c6b7", "c8d7", "b7a8",
+                           "e7e6", "g1f3", "f8e7", "f1e2", "e8g8", "e1g1"};
+    char path[] = "/tmp/chesstity_nnue_XXXXXX";
+    close(mkstemp(path));
+    write_network(path);
+    Nnue nnue = nnue_load(path);
+    TEST_ASSERT_NOT_NULL(nnue);
+
+    Game game = create_game();
+    Nnue_accumulator updated, refreshed;
+    nnue_refresh(nnue, &updated, access_state(game));
+    bool same = true;
+    for (int i = 0; i < 15; i++)
+    {
+        play_moves(game, &moves[i], 1);
+        if (8 == i)
+            upgrade_pawn(game, 'Q');
+        nnue_update(nnue, &updated, &updated, access_state(game));
+        nnue_refresh(nnue, &refreshed, access_state(game));
+        same = same && (0 == memcmp(&updated, &refreshed, sizeof(updated)))
+                    && (reference_network(access_state(game)) == nnue_evaluate(nnue, &updated, access_state(game)));
+    }
+
+    TEST_ASSERT_TRUE(same);
+
+    nnue_destroy(nnue);
+    unlink(path);
+    destroy_game(game);
+}
+
+void test_nnue_02_evaluator(void)
+{
+    char path[] = "/tmp/chesstity_nnue_XXXXXX";
+    close(mkstemp(path));
+    write_network(path);
+    Game game = create_game();
+    Evaluator evaluator = { .kind = EVALUATOR_HANDCRAFTED, .pawn_table = NULL, .nnue = nnue_load(path) };
+
+    int handcrafted = evaluator_evaluate(&evaluator, access_state(game), NULL);
+    evaluator.kind = EVALUATOR_NNUE;
+    int network = evaluator_evaluate(&evaluator, access_state(game), NULL);
+
+    TEST_ASSERT_TRUE((evaluate(access_state(game), NULL) == handcrafted)
+                  && (reference_network(access_state(game)) == network));
+
+    // one byte missing
+    truncate(path, 16 + 2 * NNUE_FEATURES * NNUE_HIDDEN + 4 * NNUE_HIDDEN + 3);
+    TEST_ASSERT_NULL(nnue_load(path));
+    TEST_ASSERT_NULL(nnue_load("/nonexistent/network"));
+
+    nnue_destroy(evaluator.nnue);
+    unlink(path);
+    destroy_game(game);
+}
 #endif
 
 int main(void)
@@ -2480,6 +4072,13 @@ int main(void)
     RUN_TEST(test_pawn_upgradable_01);
     RUN_TEST(test_pawn_upgradable_02);
     RUN_TEST(test_upgrade_pawn_01);
+    RUN_TEST(test_san_to_move_01);
+    RUN_TEST(test_san_to_move_02);
+    RUN_TEST(test_san_to_move_03_illegal);
+    RUN_TEST(test_san_to_move_04_ambiguous);
+    RUN_TEST(test_san_to_move_05_disambiguation);
+    RUN_TEST(test_san_to_move_06_castle);
+    RUN_TEST(test_san_to_move_07_promotion_check);
     #endif // TEST_CORE_INTERFACE_H
 
     #ifdef TEST_DS_LIB_H
@@ -2491,8 +4090,19 @@ int main(void)
     RUN_TEST(test_stack_int_peek_02);
     RUN_TEST(test_stack_int_pop_01);
     RUN_TEST(test_stack_int_pop_02);
+    RUN_TEST(test_stack_int_many_01);
+    RUN_TEST(test_stack_int_reserve_01);
+    RUN_TEST(test_stack_typed_01);
     #endif // TEST_DS_LIB_H
 
+    #ifdef TEST_MEM_UTILITIES_H
+    printf("\nNOW TESTING: mem_utilities.h\nImplements memory allocation helpers.\n");
+    RUN_TEST(test_pool_01_reuse);
+    RUN_TEST(test_pool_02_threads);
+    RUN_TEST(test_mem_01_statistics);
+    RUN_TEST(test_mem_02_backend);
+    #endif // TEST_MEM_UTILITIES_H
+
     #ifdef TEST_TUI_LIB_H
     printf("\nNOW TESTING: graphic_output.h\nImplements a library for displaying very simple TUIs.\n");
     // tests here got accidentally deleted
@@ -2505,9 +4115,22 @@ int main(void)
     RUN_TEST(test_screen_remove_window_01);
     RUN_TEST(test_screen_remove_window_02);
     RUN_TEST(test_screen_remove_window_03);
+    RUN_TEST(test_screen_add_window_21_many_windows);
+    RUN_TEST(test_screen_add_window_22_same_priority);
     RUN_TEST(test_window_print_01_lb_normal_and_lb_truncate_01);
     RUN_TEST(test_window_print_02_lb_normal_and_lb_truncate_02);
     RUN_TEST(test_screen_print_multiple_windows_01);
+    RUN_TEST(test_screen_render_01_diff);
+    RUN_TEST(test_screen_render_02_dirty);
+    RUN_TEST(test_screen_render_03_off_screen);
+    RUN_TEST(test_screen_render_04_shared_window);
+    RUN_TEST(test_screen_render_05_lb_smart_and_orientation);
+    RUN_TEST(test_screen_render_06_scrollback);
+    RUN_TEST(test_screen_render_07_cells);
+    RUN_TEST(test_renderer_01_publish);
+    RUN_TEST(test_renderer_02_mixed_with_screen_render);
+    // changes the order of the returned ids, which the tests above rely on
+    RUN_TEST(test_window_create_02_threads);
     #endif // TEST_TUI_LIB_H
 
     #ifdef TEST_GRAPHIC_OUTPUT_H
@@ -2515,11 +4138,14 @@ int main(void)
     RUN_TEST(test_write_current_board_01);
     RUN_TEST(test_write_current_board_02);
     RUN_TEST(test_board_window_01);
+    RUN_TEST(test_write_current_board_03_incremental);
     #endif // TEST_GRAPHIC_OUTPUT_H
 
     #ifdef TEST_INPUT_H
     printf("\nNOW TESTING: input.h\nImplements functionality reading input.\n");
     RUN_TEST(test_read_input);
+    RUN_TEST(test_input_reader_01);
+    RUN_TEST(test_input_reader_02_long_line);
     #endif // TEST_INPUT_H
 
     #ifdef TEST_SAN_PARSING_H
@@ -2561,7 +4187,51 @@ int main(void)
     RUN_TEST(test_get_san_type_castle_invalid_01);
     RUN_TEST(test_get_san_type_invalid_01);
     RUN_TEST(test_get_san_type_invalid_02);
+    RUN_TEST(test_san_lex_01_piece);
+    RUN_TEST(test_san_lex_02_pawn_promotion);
+    RUN_TEST(test_san_lex_03_both);
+    RUN_TEST(test_san_lex_04_castle);
+    RUN_TEST(test_san_lex_invalid_05);
+    RUN_TEST(test_san_lex_invalid_06);
     #endif // TEST_SAN_PARSING_H
 
+    #ifdef TEST_PGN_PARSING_H
+    printf("\nNOW TESTING: pgn_parsing.h\nImplements functionality for scanning pgn movetext.\n");
+    RUN_TEST(test_pgn_scan_01);
+    RUN_TEST(test_pgn_scan_02_boundaries);
+    RUN_TEST(test_pgn_scan_03_continue);
+    RUN_TEST(test_pgn_first_invalid_01);
+    #endif // TEST_PGN_PARSING_H
+
+    #ifdef TEST_OPENING_BOOK_H
+    printf("\nNOW TESTING: opening_book.h\nImplements functionality for probing polyglot opening books.\n");
+    RUN_TEST(test_zobrist_key_01_transposition);
+    RUN_TEST(test_zobrist_key_02_en_passant);
+    RUN_TEST(test_zobrist_key_03_polyglot);
+    RUN_TEST(test_book_move_01);
+    RUN_TEST(test_book_move_02_castling);
+    #endif // TEST_OPENING_BOOK_H
+
+    #ifdef TEST_BITBASE_H
+    printf("\nNOW TESTING: bitbase.h\nImplements generation and probing of endgame bitbases.\n");
+    RUN_TEST(test_bitbase_01_kqk);
+    RUN_TEST(test_bitbase_02_invalid);
+    #endif // TEST_BITBASE_H
+
+    #ifdef TEST_EVALUATION_H
+    printf("\nNOW TESTING: evaluation.h\nImplements static evaluation of game states.\n");
+    RUN_TEST(test_state_keys_01);
+    RUN_TEST(test_evaluate_pawns_01);
+    RUN_TEST(test_pawn_table_01);
+    RUN_TEST(test_evaluate_01);
+    RUN_TEST(test_eval_cache_01);
+    #endif // TEST_EVALUATION_H
+
+    #ifdef TEST_NNUE_H
+    printf("\nNOW TESTING: nnue.h\nImplements evaluation by a neural network.\n");
+    RUN_TEST(test_nnue_01_update);
+    RUN_TEST(test_nnue_02_evaluator);
+    #endif // TEST_NNUE_H
+
     return UNITY_END();
 }
@@ -0,0 +1,275 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+//
+// tui_bench.c
+// measures how fast tui_lib produces frames
+//
+// usage: tui_bench.x [options]
+//   -n windows     number of windows (default 300)
+//   -f frames      number of frames (default 2000)
+//   -r rows        height of the screen (default 50)
+//   -c columns     width of the screen (default 200)
+//   -s HxW         maximum size of a window (default 18x50)
+//   -l mode        linebreak mode: normal, truncate or smart (default normal)
+//   -m moves       windows moved per frame (default 4)
+//   -u updates     windows getting new content per frame (default 4)
+//   -o sink        memory: screen_render() only,
+//                  null: screen_print() with stdout on /dev/null
+//                  (default memory)
+//
+// Windows are placed at random positions, many of them partly or
+// completely off screen (some at the limits of int).
+// Reports frames per second, the worst time per frame, bytes
+// emitted and allocations per frame, followed by the memory tui_lib
+// holds (see mem_dump() in mem_utilities.h).
+//
+// The allocations and the bytes written are counted by wrapping
+// malloc(), calloc(), realloc(), free() and write() at link time
+// (see the Makefile), so tui_lib itself is measured unchanged.
+//
+
+#include "tui_lib.h"
+#include "mem_utilities.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct options {
+    int windows;
+    int frames;
+    int rows;
+    int columns;
+    int max_height;
+    int max_width;
+    Linebreak linebreak;
+    int moves;
+    int updates;
+    bool null_sink;
+} Options;
+
+static long allocations = 0;
+static long bytes_written = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t number, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void __real_free(void *pointer);
+ssize_t __real_write(int fd, const void *buffer, size_t count);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t number, size_t size)
+{
+    allocations++;
+    return __real_calloc(number, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    allocations++;
+    return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void *pointer)
+{
+    __real_free(pointer);
+}
+
+ssize_t __wrap_write(int fd, const void *buffer, size_t count)
+{
+    ssize_t written = __real_write(fd, buffer, count);
+    if ((STDOUT_FILENO == fd) && (0 < written))
+        bytes_written += written;
+    return written;
+}
+
+// returns a position for a window, mostly around the screen
+static int random_position(int screen_size)
+{
+    switch (rand() % 8)
+    {
+        case 0:     return INT_MIN + rand() % 100;
+        case 1:     return INT_MAX - rand() % 100;
+        default:    return rand() % (3 * screen_size + 1) - screen_size;
+    }
+}
+
+// writes new content of about 200 characters to window
+static void churn_content(Window window, int frame)
+{
+    char content[256];
+    int length = snprintf(content, sizeof(content),
+                          "frame %d\n%d. e4 e5 %d. Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Nb8 d4 Nbd7\n"
+                          "The quick brown fox jumps over the lazy dog, again and again and again.",
+                          frame, frame % 100, frame % 100 + 1);
+    window_update_content(window, content, length);
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n windows] [-f frames] [-r rows] [-c columns] [-s HxW]"
+                    " [-l normal|truncate|smart] [-m moves] [-u updates] [-o memory|null]\n", name);
+}
+
+static bool parse_options(int argc, char **argv, Options *options)
+{
+    *options = (Options) { .windows = 300, .frames = 2000, .rows = 50, .columns = 200,
+                           .max_height = 18, .max_width = 50, .linebreak = LB_NORMAL,
+                           .moves = 4, .updates = 4, .null_sink = false };
+    int option;
+    while (-1 != (option = getopt(argc, argv, "n:f:r:c:s:l:m:u:o:")))
+    {
+        switch (option)
+        {
+            case 'n':   options->windows = atoi(optarg);
+                        break;
+            case 'f':   options->frames = atoi(optarg);
+                        break;
+            case 'r':   options->rows = atoi(optarg);
+                        break;
+            case 'c':   options->columns = atoi(optarg);
+                        break;
+            case 's':   if (2 != sscanf(optarg, "%dx%d", &options->max_height, &options->max_width))
+                            return false;
+                        break;
+            case 'l':   if (0 == strcmp(optarg, "normal"))
+                            options->linebreak = LB_NORMAL;
+                        else if (0 == strcmp(optarg, "truncate"))
+                            options->linebreak = LB_TRUNCATE;
+                        else if (0 == strcmp(optarg, "smart"))
+                            options->linebreak = LB_SMART;
+                        else
+                            return false;
+                        break;
+            case 'm':   options->moves = atoi(optarg);
+                        break;
+            case 'u':   options->updates = atoi(optarg);
+                        break;
+            case 'o':   if (0 == strcmp(optarg, "memory"))
+                            options->null_sink = false;
+                        else if (0 == strcmp(optarg, "null"))
+                            options->null_sink = true;
+                        else
+                            return false;
+                        break;
+            default:    return false;
+        }
+    }
+    return (0 < options->windows) && (0 < options->frames) && (0 < options->rows) && (0 < options->columns)
+        && (0 < options->max_height) && (0 < options->max_width) && (0 <= options->moves) && (0 <= options->updates);
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, &options))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Screen screen = screen_create();
+    screen_set_size(screen, options.rows, options.columns);
+    Window *windows = malloc(options.windows * sizeof(*windows));
+    if (NULL == windows)
+        return EXIT_FAILURE;
+
+    srand(1);
+    for (int i = 0; i < options.windows; i++)
+    {
+        windows[i] = window_create();
+        window_set_size(windows[i], 1 + rand() % options.max_height, 1 + rand() % options.max_width);
+        window_set_linebreak(windows[i], options.linebreak);
+        churn_content(windows[i], 0);
+        window_display_frame(windows[i], true);
+        window_set_frame(windows[i], '-', '|', '+');
+        screen_add_window(screen, windows[i], i);
+        screen_window_set_position(screen, windows[i], random_position(options.rows), random_position(options.columns));
+    }
+
+    int saved_stdout = -1;
+    if (options.null_sink)
+    {
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+
+    long bytes = 0;
+    long frame_allocations = 0;
+    double total = 0;
+    double worst = 0;
+    for (int frame = 1; frame <= options.frames; frame++)
+    {
+        for (int i = 0; i < options.moves; i++)
+        {
+            screen_window_set_position(screen, windows[rand() % options.windows],
+                                       random_position(options.rows), random_position(options.columns));
+        }
+        for (int i = 0; i < options.updates; i++)
+            churn_content(windows[rand() % options.windows], frame);
+
+        long allocations_before = allocations;
+        long bytes_before = bytes_written;
+        double start = seconds();
+        if (options.null_sink)
+        {
+            screen_print(screen);
+        }
+        else
+        {
+            int length;
+            screen_render(screen, &length);
+            bytes_written += length;
+        }
+        double time = seconds() - start;
+
+        frame_allocations += allocations - allocations_before;
+        bytes += bytes_written - bytes_before;
+        total += time;
+        if (time > worst)
+            worst = time;
+    }
+
+    if (options.null_sink)
+    {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    static const char *linebreaks[] = {"", "normal", "truncate", "smart"};
+    printf("%d frames, %d windows (up to %dx%d, %s) on %dx%d, %d moves and %d updates per frame, %s sink\n",
+           options.frames, options.windows, options.max_height, options.max_width, linebreaks[options.linebreak],
+           options.rows, options.columns, options.moves, options.updates, options.null_sink ? "null" : "memory");
+    printf("frames/s:          %10.0f\n", options.frames / total);
+    printf("average us/frame:  %10.1f\n", 1e6 * total / options.frames);
+    printf("worst us/frame:    %10.1f\n", 1e6 * worst);
+    printf("bytes/frame:       %10.1f\n", (double) bytes / options.frames);
+    printf("allocations/frame: %10.2f\n", (double) frame_allocations / options.frames);
+    mem_dump(stdout);
+
+    for (int i = 0; i < options.windows; i++)
+        window_destroy(windows[i]);
+    screen_destroy(screen);
+    free(windows);
+    return EXIT_SUCCESS;
+}
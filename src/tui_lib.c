@@ -8,9 +8,11 @@
  * Use tui_lib.h to access the 
  *
  * Overview Screen:
- * Screens are linked lists of nodes pointing to windows.
+ * Screens are arrays of nodes pointing to windows.
  * Each node in a Screen has a priority assigned to it.
- * The nodes in a Screen are ordered by priority.
+ * The nodes in a Screen are ordered by priority, so the position
+ * for a priority is found by binary search. A hash table from the
+ * window id to the node finds the node of a window.
  *
  * Overview Window:
  * Windows contain the following information:
@@ -19,10 +21,29 @@
  * content (a string)
  * a list of all the screens it is in
  *
+ * The content is broken into display lines once after it or the
+ * linebreak mode changed, the lines are kept as spans of the
+ * content. Redrawing a window only copies the visible spans, and
+ * changing its size only breaks the content again if the width of
+ * the content area reaches the longest line.
+ * Scrollback windows keep a ring of lines instead of content and
+ * break only the lines which are visible, every time they are drawn.
+ *
  * A screen can be drawn, with specified height and width.
- * This effectively creates a string of ' ' and '\n' wich repeatedly
- * gets partly overriden with the content of the screen's windows.
- * In the end this string will be sent to stdout with printf().
+ * This effectively fills a buffer of height * width characters
+ * with the background, which then gets partly overriden row by row
+ * with the buffers of the screen's windows. The buffers are kept
+ * between frames and only reallocated when they have to grow.
+ * Every node of a screen remembers where it drew its window.
+ * Every change of a window is pushed to all screens in its list of
+ * screens, which mark the rectangle the window covered before and
+ * the one it covers now as dirty. Moving, adding and removing
+ * windows marks their rectangles as well. Only the dirty
+ * rectangles are composited again, the rest of the buffer is kept.
+ * The screen remembers the last frame it has written to the
+ * terminal. When it is drawn again only the runs of characters
+ * which differ from that frame are written, each preceded by an
+ * ANSI sequence moving the cursor there.
  *
  ********************************************************************/
 // comment out the following line to disable debugging
@@ -33,7 +54,6 @@
 #define PRIVATE static
 #endif
 
-#include "ds_lib.h"
 #include "tui_lib.h"
 #include "mem_utilities.h"
 #include <ctype.h>
@@ -42,14 +62,36 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 
 // Denotes the maximum number of windows/screens, that can exist at the same time.
 // Keeps track of the amount of created windows/screens. Assigns a unique id to each window/screen.
 #define MAX_WINDOWS_SCREENS_ID INT_MAX
 
+// Unchanged characters between two changed ones are written as well,
+// if there are not more of them than this. Moving the cursor costs
+// at least as many bytes.
+#define DIFF_MAX_GAP 8
+
+// Number of separate dirty rectangles a screen keeps. When there
+// are more, they are merged into one.
+#define SCREEN_DIRTY_RECTS 16
+
+// The links of the free list of ids are kept in chunks of this many
+// ids, allocated when the first id of a chunk is returned.
+#define ID_CHUNK_SIZE 16384
+#define ID_CHUNKS (MAX_WINDOWS_SCREENS_ID / ID_CHUNK_SIZE + 1)
+
 #define MIN(x, y) (((x) <= (y)) ? (x) : (y))
 #define MAX(x, y) (((x) >= (y)) ? (x) : (y))
 
+// cells are copied around a lot, they should stay small
+_Static_assert(sizeof(Cell) <= 8, "Cell should not be larger than 8 bytes");
+
 typedef enum orientation_i {
     LEFT_i = 1,
     CENTER_i = 2,
@@ -62,6 +104,60 @@ typedef enum linebreak_i {
     LB_SMART_i = 3,
 } Linebreak_i;
 
+// an area of a screen, empty if height or width are <= 0
+typedef struct rect {
+    int row;
+    int column;
+    int height;
+    int width;
+} Rect;
+
+// The frame last written to a terminal (height * width cells)
+// and the output written next, reused for every frame.
+// style is the style the terminal draws with while the output is
+// written, every frame starts and ends with style 0.
+// diffed is the number of the frame last diffed, frames with the
+// same number are not compared again.
+// Owned by a Screen for screen_print(), or by a Renderer.
+typedef struct emitted_frame {
+    Cell *frame;
+    int height;
+    int width;
+    char *output;
+    int output_length;
+    int output_capacity;
+    uint32_t style;
+    unsigned long diffed;
+} Emitted_frame;
+
+// A line of content as it is displayed: length cells from text,
+// without the '\n'. Kept in Window, see window_layout().
+typedef struct line_span {
+    const Cell *text;
+    int length;
+} Line_span;
+
+// a line of a scrollback window, without the '\n'
+typedef struct log_line {
+    Cell *text;
+    int length;
+    int capacity;
+} Log_line;
+
+// Content of a scrollback window: a ring of up to capacity lines,
+// the oldest at lines[first]. open tells that the newest line did
+// not end with '\n' yet. offset newest lines are hidden below the
+// view.
+typedef struct scrollback {
+    Log_line *lines;
+    int capacity;
+    int first;
+    int number;
+    bool open;
+    int offset;
+    bool follow;
+} *Scrollback;
+
 // nodes of Window_screen_list, see below
 typedef struct node_ptr_to_screen {
     Screen screen;
@@ -89,6 +185,8 @@ struct window {
     // filler variables
     char fill_line;
     char fill_border;
+    // style of the frame, the fillers and content cells of style 0
+    uint32_t style;
     // space at border (all >= 0)
     int space_top;
     int space_bot;
@@ -97,22 +195,39 @@ struct window {
     // content variables
     Orientation_i content_orientation;
     Linebreak_i content_lb_mode;
+    // content_length cells and a cell of code point 0
     int content_length;
-    char *content;
-    // display_strings;
-    char **display_strings;
+    int content_capacity;
+    Cell *content;
+    // lines_number display lines of content, broken for a content
+    // area of layout_width characters (layout_width < 0: not laid
+    // out since content or content_lb_mode changed)
+    Line_span *lines;
+    int lines_number;
+    int lines_capacity;
+    int layout_width;
+    // length of the longest line of content
+    int layout_longest;
+    // NULL unless window is a scrollback window, which shows these
+    // lines instead of content
+    Scrollback scrollback;
+    // height * width cells, row after row
+    Cell *display;
+    int display_capacity;
     bool changed;
-    int old_height;
     Window_screen_list screens;
 };
 
 // Nodes for screens
 typedef struct node_ptr_to_window {
-    int priority;
+    // the priority of the node minus the priority_bias of its screen
+    long long priority;
     int pos_hori;
     int pos_vert;
     Window window;
-    struct node_ptr_to_window *next;
+    // where window was drawn the last time, or will be drawn, if
+    // the rectangle was marked dirty since
+    Rect drawn;
 } Node_ptr_to_window;
 
 // typedef in tui_lib.h
@@ -122,18 +237,74 @@ struct screen {
     int width;
     char background;
     bool changed;
-    int old_height;
-    char **display_strings;
-    Node_ptr_to_window *lowest;
+    // height * width cells, row after row
+    Cell *display;
+    int display_capacity;
+    // parts of display which have to be composited again (all of it if changed)
+    Rect dirty[SCREEN_DIRTY_RECTS];
+    int dirty_number;
+    // counts the compositings of display, so every emitted frame
+    // can tell whether display changed since it was diffed
+    unsigned long frame_number;
+    // nodes_number nodes, ordered by priority, lowest first
+    Node_ptr_to_window **nodes;
+    int nodes_number;
+    int nodes_capacity;
+    // added to the priorities stored in the nodes, lowering it
+    // downgrades all of them at once
+    long long priority_bias;
+    // hash table of the nodes by window id, open addressing with
+    // linear probing, at most half full (by_id_capacity is a power
+    // of two)
+    Node_ptr_to_window **by_id;
+    int by_id_capacity;
+    // written by screen_render()
+    Emitted_frame emitted;
+};
+
+// typedef in tui_lib.h
+// The thread writes the working frame, while the next one can be
+// published into pending. Frames published while pending was not
+// taken yet replace it.
+struct renderer {
+    int fd;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t published;      // signaled when pending is ready or stop is set
+    pthread_cond_t written;        // signaled when the thread finished a frame
+    Cell *pending;
+    int pending_capacity;
+    int pending_height;
+    int pending_width;
+    bool pending_ready;
+    Cell *working;
+    int working_capacity;
+    int working_height;
+    int working_width;
+    bool busy;
+    bool stop;
+    long frames_published;
+    long frames_written;
+    Emitted_frame emitted;         // only used by the thread
 };
 
 // keeps track of available ids for windows/screens
-// ids of destroyed windows/screens go onto the stack
+// ids of destroyed windows/screens go onto a lock-free stack
 // when creating a new window/screen it is first looked for
 // available ids on the stack.
 // If none is present, the counter will be increased by one.
-PRIVATE int id_counter = 1;
-PRIVATE Stack_int returned_ids = NULL;
+// The stack is linked through id_links[id / ID_CHUNK_SIZE][id % ID_CHUNK_SIZE]
+// (0 ends it). returned_ids holds the top id in the lower 32 bits and a
+// counter of changes in the upper ones, so a compare and swap fails if
+// the top was popped and pushed again in between.
+PRIVATE atomic_long id_counter = 1;
+PRIVATE _Atomic uint64_t returned_ids = 0;
+PRIVATE _Atomic(atomic_int *) id_links[ID_CHUNKS];
+
+// the nodes of screens and of Window_screen_lists, created on first use
+PRIVATE pthread_once_t node_pools_once = PTHREAD_ONCE_INIT;
+PRIVATE Pool window_nodes = NULL;
+PRIVATE Pool screen_nodes = NULL;
 
 PRIVATE Window_screen_list screen_list_create(void);
 PRIVATE void window_add_screen(Window window, Screen screen);
@@ -141,40 +312,135 @@ PRIVATE void window_remove_screen(Window window, Screen screen);
 PRIVATE void window_screen_list_destroy(Window window);
 PRIVATE void screen_remove_window_simple(Screen screen, Window window);
 PRIVATE int get_id(void);
-PRIVATE char **window_make_strings(Window window);
+PRIVATE void return_id(int id);
+PRIVATE atomic_int *id_link(int id);
+PRIVATE void node_pools_create(void);
+PRIVATE void node_pools_init(void);
+PRIVATE void window_make_strings(Window window);
+PRIVATE void window_layout(Window window, int width);
+PRIVATE bool window_layout_valid(Window window, int width);
+PRIVATE void window_layout_scrollback(Window window, int width, int rows);
+PRIVATE void window_break_line(Window window, const Cell *text, int length, bool newline, int width);
+PRIVATE void window_add_line(Window window, const Cell *text, int length);
+PRIVATE void window_reserve_content(Window window, int length);
+PRIVATE void window_reverse_lines(Window window, int from);
+PRIVATE Log_line *scrollback_line(Scrollback scrollback, int index);
+PRIVATE void scrollback_append(Scrollback scrollback, const Cell *cells, int length);
+PRIVATE void scrollback_append_utf8(Scrollback scrollback, const char *text, int length);
+PRIVATE int utf8_to_cells(const char **text, int *length, Cell *cells, int capacity);
+PRIVATE int utf8_decode(const char *text, int length, uint32_t *codepoint);
+PRIVATE int utf8_encode(uint32_t codepoint, char *bytes);
+PRIVATE void scrollback_clear(Scrollback scrollback);
+PRIVATE void scrollback_destroy(Scrollback scrollback);
 PRIVATE void window_update_strings(Window window);
-PRIVATE char **screen_make_strings(Screen screen);
-PRIVATE void screen_update_strings(Screen screen);
+PRIVATE void window_mark_changed(Window window);
+PRIVATE void screen_make_strings(Screen screen, Rect rect);
+PRIVATE bool screen_update_strings(Screen screen);
+PRIVATE void screen_mark_dirty(Screen screen, Rect rect);
+PRIVATE void screen_mark_node(Screen screen, Node_ptr_to_window *node);
+PRIVATE Node_ptr_to_window *screen_find_node(Screen screen, Window window);
+PRIVATE int screen_node_index(Screen screen, long long priority);
+PRIVATE void screen_insert_node(Screen screen, Node_ptr_to_window *node, int index);
+PRIVATE void screen_erase_node(Screen screen, int index);
+PRIVATE void screen_unlink_node(Screen screen, Node_ptr_to_window *node);
+PRIVATE void by_id_insert(Screen screen, Node_ptr_to_window *node);
+PRIVATE void by_id_remove(Screen screen, Node_ptr_to_window *node);
+PRIVATE unsigned int by_id_slot(Screen screen, int id);
+PRIVATE Rect node_rect(const Node_ptr_to_window *node);
+PRIVATE Rect rect_intersection(Rect a, Rect b);
+PRIVATE bool rect_empty(Rect rect);
+PRIVATE bool rect_touching(Rect a, Rect b);
+PRIVATE Rect rect_union(Rect a, Rect b);
+PRIVATE bool rect_contains(Rect outer, Rect inner);
+PRIVATE void display_reserve(Cell **display, int *capacity, int size);
+PRIVATE void emitted_frame_diff(Emitted_frame *emitted, const Cell *display, int height, int width, unsigned long frame_number);
+PRIVATE void emitted_frame_free_frame(Emitted_frame *emitted);
+PRIVATE void emitted_frame_free(Emitted_frame *emitted);
+PRIVATE void output_append(Emitted_frame *emitted, const char *bytes, int length);
+PRIVATE void output_reserve(Emitted_frame *emitted, int length);
+PRIVATE void output_cells(Emitted_frame *emitted, const Cell *cells, int length);
+PRIVATE void output_style(Emitted_frame *emitted, uint32_t style);
+PRIVATE void output_color(char **sequence, int color, int base, int bright_base, int palette);
+PRIVATE void output_move_cursor(Emitted_frame *emitted, int row, int column);
+PRIVATE void render_row(Emitted_frame *emitted, const Cell *current, Cell *previous, bool full, int row);
+PRIVATE bool cells_equal(Cell a, Cell b);
+PRIVATE void *renderer_thread(void *argument);
+PRIVATE bool write_all(int fd, const char *bytes, int length);
 
 /********************************************************************
  * get_id: Returns a valid unique id.
  *         0 is reserved as errorcode.
  *         When 0 is returned no more valid unique ids are available.
+ *         Can be called from several threads at once.
  ********************************************************************/
 PRIVATE int get_id(void)
 {
-    if (NULL == returned_ids)
+    uint64_t top = atomic_load(&returned_ids);
+    while (0 != (uint32_t) top)
     {
-        returned_ids = stack_int_create();
-        if (id_counter > MAX_WINDOWS_SCREENS_ID)
-            return 0;
-        return id_counter++;
+        int id = (int) (uint32_t) top;
+        uint64_t next = ((top >> 32) + 1) << 32 | (uint32_t) atomic_load(id_link(id));
+        if (atomic_compare_exchange_weak(&returned_ids, &top, next))
+            return id;
     }
 
-    int id;
-    if (!stack_int_pop(returned_ids, &id))
+    long id = atomic_fetch_add(&id_counter, 1);
+    if (id > MAX_WINDOWS_SCREENS_ID)
+        return 0;
+    return id;
+}
+
+/********************************************************************
+ * return_id: Makes id available to get_id() again.
+ *            Can be called from several threads at once.
+ ********************************************************************/
+PRIVATE void return_id(int id)
+{
+    uint64_t top = atomic_load(&returned_ids);
+    do
     {
-        if (id_counter > MAX_WINDOWS_SCREENS_ID)
-            return 0;
-        else
+        atomic_store(id_link(id), (int) (uint32_t) top);
+    } while (!atomic_compare_exchange_weak(&returned_ids, &top, ((top >> 32) + 1) << 32 | (uint32_t) id));
+}
+
+/********************************************************************
+ * id_link: Returns the link of id in the stack of returned ids.
+ *          The chunk of id is created when the first of its ids
+ *          is returned. If two threads do that at once, the one
+ *          losing the race frees its chunk.
+ ********************************************************************/
+PRIVATE atomic_int *id_link(int id)
+{
+    atomic_int *chunk = atomic_load(&id_links[id / ID_CHUNK_SIZE]);
+    if (NULL == chunk)
+    {
+        chunk = mem_calloc(MEM_TUI, ID_CHUNK_SIZE, sizeof(*chunk));
+        atomic_int *expected = NULL;
+        if (!atomic_compare_exchange_strong(&id_links[id / ID_CHUNK_SIZE], &expected, chunk))
         {
-            if (0 == id_counter)
-                id_counter++;
-            id = id_counter++;
+            mem_free(MEM_TUI, chunk, ID_CHUNK_SIZE * sizeof(*chunk));
+            chunk = expected;
         }
     }
-    return id;
-} 
+    return chunk + id % ID_CHUNK_SIZE;
+}
+
+/********************************************************************
+ * node_pools_create: Creates window_nodes and screen_nodes, if that
+ *                    did not happen yet. Windows and screens can be
+ *                    built on several threads, so the pools are
+ *                    thread-safe.
+ ********************************************************************/
+PRIVATE void node_pools_create(void)
+{
+    pthread_once(&node_pools_once, node_pools_init);
+}
+
+PRIVATE void node_pools_init(void)
+{
+    window_nodes = pool_create(sizeof(Node_ptr_to_window), POOL_THREADS);
+    screen_nodes = pool_create(sizeof(Node_ptr_to_screen), POOL_THREADS);
+}
 
 /********************************************************************
  * window_create: Returns NULL if no more ids are available.
@@ -195,8 +461,7 @@ Window window_create(void)
     }
 
     // creating new window
-    Window new_window = malloc(sizeof(*new_window));
-    MEM_TEST(new_window);
+    Window new_window = mem_alloc(MEM_TUI, sizeof(*new_window));
 
     // setting default values
     new_window->id = id;
@@ -212,17 +477,25 @@ Window window_create(void)
     new_window->delim_corner = ' ';
     new_window->fill_line = ' ';
     new_window->fill_border = ' ';
+    new_window->style = 0;
     new_window->content_orientation = LEFT_i;
-    Linebreak_i content_lb_mode = LB_NORMAL_i;
+    new_window->content_lb_mode = LB_NORMAL_i;
     new_window->content_length = 0;
-    // +1 for '\0'
-    new_window->content = malloc((new_window->content_length) * sizeof(*new_window->content));
-    MEM_TEST(new_window->content);
-    *(new_window->content + new_window->content_length) = '\0';
-
-    new_window->display_strings = window_make_strings(new_window);
+    // +1 for the cell ending the content
+    new_window->content_capacity = new_window->content_length + 1;
+    new_window->content = mem_alloc(MEM_TUI, new_window->content_capacity * sizeof(*new_window->content));
+    new_window->content[new_window->content_length] = (Cell) {0, 0};
+    new_window->lines = NULL;
+    new_window->lines_number = 0;
+    new_window->lines_capacity = 0;
+    new_window->layout_width = -1;
+    new_window->layout_longest = 0;
+    new_window->scrollback = NULL;
+
+    new_window->display = NULL;
+    new_window->display_capacity = 0;
+    window_make_strings(new_window);
     new_window->changed = false;
-    new_window->old_height = 0;
 
     new_window->screens = screen_list_create();
 
@@ -236,8 +509,7 @@ Window window_create(void)
  ********************************************************************/
 PRIVATE Window_screen_list screen_list_create(void)
 {
-    Window_screen_list new_screen_list = malloc(sizeof(*new_screen_list));
-    MEM_TEST(new_screen_list);
+    Window_screen_list new_screen_list = mem_alloc(MEM_TUI, sizeof(*new_screen_list));
 
     new_screen_list->first = NULL;
     return new_screen_list;
@@ -258,22 +530,10 @@ PRIVATE Window_screen_list screen_list_create(void)
  ********************************************************************/
 PRIVATE void screen_remove_window_simple(Screen screen, Window window)
 {
-    Node_ptr_to_window *p = screen->lowest;
-    Node_ptr_to_window *p_prev = NULL;
-    while (p->window->id != window->id)
-    {
-        p_prev = p;
-        p = p->next;
-    }
-
-    if (NULL != p_prev)
-        p_prev->next = p->next;
-    else
-        screen->lowest = p->next;
-
-    free(p);
-
-    screen->changed = true;
+    Node_ptr_to_window *p = screen_find_node(screen, window);
+    screen_unlink_node(screen, p);
+    screen_mark_dirty(screen, p->drawn);
+    pool_free(window_nodes, p);
 }
 
 /********************************************************************
@@ -291,9 +551,9 @@ PRIVATE void window_screen_list_destroy(Window window)
         screen_remove_window_simple(p->screen, window);
         temp = p;
         p = p->next;
-        free(temp);
+        pool_free(screen_nodes, temp);
     }
-    free(window->screens);
+    mem_free(MEM_TUI, window->screens, sizeof(*window->screens));
 }
 
 /********************************************************************
@@ -304,8 +564,8 @@ PRIVATE void window_screen_list_destroy(Window window)
  ********************************************************************/
 PRIVATE void window_add_screen(Window window, Screen screen)
 {
-    Node_ptr_to_screen *new_node = malloc(sizeof(*new_node));
-    MEM_TEST(new_node);
+    node_pools_create();
+    Node_ptr_to_screen *new_node = pool_alloc(screen_nodes);
 
     new_node->screen = screen;
     new_node->next = window->screens->first;
@@ -336,7 +596,7 @@ PRIVATE void window_remove_screen(Window window, Screen screen)
     else
         p_prev->next = p->next;
 
-    free(p);
+    pool_free(screen_nodes, p);
 }
 
 /********************************************************************
@@ -352,18 +612,26 @@ Screen screen_create(void)
         return NULL;
     }
 
-    Screen new_screen = malloc(sizeof(*new_screen));
-    MEM_TEST(new_screen);
+    Screen new_screen = mem_alloc(MEM_TUI, sizeof(*new_screen));
 
     new_screen->id = id;
     new_screen->height = 0;
     new_screen->width = 0;
-    new_screen->lowest = NULL;
+    new_screen->nodes = NULL;
+    new_screen->nodes_number = 0;
+    new_screen->nodes_capacity = 0;
+    new_screen->priority_bias = 0;
+    new_screen->by_id = NULL;
+    new_screen->by_id_capacity = 0;
     new_screen->background = ' ';
 
     new_screen->changed = false;
-    new_screen->old_height = 0;
-    new_screen->display_strings = NULL;
+    new_screen->display = NULL;
+    new_screen->display_capacity = 0;
+    new_screen->dirty_number = 0;
+    new_screen->frame_number = 0;
+
+    new_screen->emitted = (Emitted_frame) {NULL, 0, 0, NULL, 0, 0, 0, 0};
 
     return new_screen;
 }
@@ -387,7 +655,6 @@ bool screen_set_size(Screen screen, int height, int width)
     if ((height < 0) || (width < 0))
         return false;
 
-    screen->old_height = screen->height;
     screen->height = height;
     screen->width = width;
     screen->changed = true;
@@ -403,151 +670,64 @@ bool screen_set_size(Screen screen, int height, int width)
  *                    If priority is already occupied, downgrade all
  *                    existing priorities lesser or equal to it by
  *                    one, so that window can have the priority.
+ *                    The downgrade lowers screen->priority_bias and
+ *                    raises the stored priorities above the
+ *                    occupied one instead, so adding windows on top
+ *                    of each other with the same priority does not
+ *                    touch the other nodes.
  *                    Returns false, if downgrade is requested,
  *                    but not possible due to integer overflow.
  ********************************************************************/
 bool screen_add_window(Screen screen, Window window, int priority)
 {
-    // simplify the process if screen is empty
-    // also test is necessary to make sure that screen->lowest
-    // can be safely accessed in the following
-    if (NULL == screen->lowest)
-    {
-        Node_ptr_to_window *new_node = malloc(sizeof(*new_node));
-        MEM_TEST(new_node);
-        new_node->window = window;
-        new_node->priority = priority;
-        new_node->pos_hori = 0;
-        new_node->pos_vert = 0;
-        new_node->next = NULL;
-        screen->lowest = new_node;
-        window_add_screen(window, screen);
-        return true;
-    }
-
-    // check for possibility to downgrade existing priorities
-    bool downgrade_prios_legal = true;
-    if (INT_MIN >= screen->lowest->priority)
-        downgrade_prios_legal = false;
-
-    // new_position will point to the node,
-    // where the node pointing to window will point to with ->next.
-    // new_position_prev will point to the node,
-    // that will point with ->next to the node pointing to window.
-    // old_position will end up pointing to the node.
-    // that points to window.
-    // old_position_prev will point to the node,
-    // before the node that is pointed to by old_position.
-    Node_ptr_to_window *new_position = NULL;
-    Node_ptr_to_window *new_position_prev = NULL;
-    Node_ptr_to_window *old_position = NULL;
-    Node_ptr_to_window *old_position_prev = NULL;
-
-    // find the new_position, where window's node should be inserterd
-    // if window already is in screen find it's current position i.e. old_position
-    Node_ptr_to_window *p = screen->lowest;
-    Node_ptr_to_window *p_prev = NULL;
-    while ((NULL != p) && ((NULL == old_position) || (NULL == new_position)))
-    {
-        // find new position
-        if ((NULL == new_position) && (p->priority >= priority))
-        {
-            if (p->priority == priority)
-            {
-                // check if the found node already points to window
-                if (p->window->id == window->id)
-                    return true;
-                else if (downgrade_prios_legal)
-                {
-                    //downgrade priorities
-                    Node_ptr_to_window *q = screen->lowest;
-                    while ((NULL != q) && (q != p))
-                    {
-                        q->priority--;
-                        q = q->next;
-                    }
-                    p->priority--;
-                }
-                else
-                    return false;
-
-                new_position = p->next;
-                new_position_prev = p;
-            }
-            else
-            {
-                new_position = p;
-                new_position_prev = p_prev;
-            }
-        }
-        // find old position
-        if ((NULL == old_position) && (p->window->id == window->id))
-        {
-            // if window already has priority, return
-            if (p->priority == priority)
-                return true;
-            // otherwise save it's position in old_position
-            else
-            {
-                old_position = p;
-                old_position_prev = p_prev;
-            }
-        }
-        // advance search
-        p_prev = p;
-        p = p->next;
-    }
-
-    // if priority is larger than all priorities existing in screen
-    // prepare for inserting windows node at the end of the list
-    if (NULL == new_position)
+    long long stored = priority - screen->priority_bias;
+    int index = screen_node_index(screen, stored);
+    if ((index < screen->nodes_number) && (screen->nodes[index]->priority == stored))
     {
-        if (p_prev != old_position)
-            new_position_prev = p_prev;
-        else
-        {
-            old_position->priority = priority;
+        // check if the found node already points to window
+        if (screen->nodes[index]->window->id == window->id)
             return true;
-        }
-    }
-    else if (new_position == old_position)
-    {
-        old_position->priority = priority;
-        return true;
+        // downgrade priorities
+        if (INT_MIN >= screen->nodes[0]->priority + screen->priority_bias)
+            return false;
+        screen->priority_bias--;
+        for (int i = index + 1; i < screen->nodes_number; i++)
+            screen->nodes[i]->priority++;
+        stored++;
+        index++;
     }
 
+    Node_ptr_to_window *node = screen_find_node(screen, window);
     // create a new node for the window if it is not yet in screen
-    // otherwise change the nodes position form old_position to new_position
-    if (NULL == old_position)
+    if (NULL == node)
     {
-        Node_ptr_to_window *new_node = malloc(sizeof(*new_node));
-        MEM_TEST(new_node);
-        new_node->window = window;
-        new_node->priority = priority;
-        new_node->pos_hori = 0;
-        new_node->pos_vert = 0;
-        new_node->next = new_position;
-        if (NULL == new_position_prev)
-            screen->lowest = new_node;
-        else
-            new_position_prev->next = new_node;
+        node_pools_create();
+        node = pool_alloc(window_nodes);
+        node->window = window;
+        node->priority = stored;
+        node->pos_hori = 0;
+        node->pos_vert = 0;
+        node->drawn = (Rect) {0, 0, 0, 0};
+        screen_insert_node(screen, node, index);
+        by_id_insert(screen, node);
         window_add_screen(window, screen);
-    }
-    else
-    {
-        if (NULL == old_position_prev)
-            screen->lowest = old_position->next;
-        else
-            old_position_prev->next = old_position->next;
-        if (NULL == new_position_prev)
-            screen->lowest = old_position;
-        else
-            new_position_prev->next = old_position;
-        old_position->next = new_position;
-        old_position->priority = priority;
+        screen_mark_node(screen, node);
+        return true;
     }
 
-    screen->changed = true;
+    // otherwise move the node to its new index
+    int old_index = screen_node_index(screen, node->priority);
+    node->priority = stored;
+    if ((old_index == index) || (old_index + 1 == index))
+        return true;
+
+    screen_erase_node(screen, old_index);
+    if (old_index < index)
+        index--;
+    screen_insert_node(screen, node, index);
+    // the window is now drawn above or below other windows
+    screen_mark_dirty(screen, node->drawn);
+
     return true;
 }
 
@@ -560,27 +740,16 @@ bool screen_add_window(Screen screen, Window window, int priority)
  ********************************************************************/
 bool screen_remove_window(Screen screen, Window window)
 {
-    Node_ptr_to_window *p = screen->lowest;
-    Node_ptr_to_window *p_prev = NULL;
-    while (NULL != p)
-    {
-        if (p->window->id == window->id)
-        {
-            if (NULL == p_prev)
-                screen->lowest = p->next;
-            else
-                p_prev->next = p->next;
-            // remove screen from window
-            window_remove_screen(window, screen);
-            free(p);
-            screen->changed = true;
-            return true;
-        }
-        p_prev = p;
-        p = p->next;
-    }
+    Node_ptr_to_window *p = screen_find_node(screen, window);
+    if (NULL == p)
+        return false;
 
-    return false;
+    screen_unlink_node(screen, p);
+    // remove screen from window
+    window_remove_screen(window, screen);
+    screen_mark_dirty(screen, p->drawn);
+    pool_free(window_nodes, p);
+    return true;
 }
 
 /********************************************************************
@@ -591,22 +760,14 @@ bool screen_remove_window(Screen screen, Window window)
  ********************************************************************/
 void window_destroy(Window window)
 {
-    if (NULL == returned_ids)
-        returned_ids = stack_int_create();
-
-    stack_int_push(returned_ids, window->id);
+    return_id(window->id);
     window_screen_list_destroy(window);
-    free(window->content);
-
-    for (char **p = window->display_strings;
-            p < window->display_strings + ((window->changed) ? window->old_height : window->height);
-            p++)
-    {
-        free(*p);
-    }
-    free(window->display_strings);
-
-    free(window);
+    mem_free(MEM_TUI, window->content, window->content_capacity * sizeof(*window->content));
+    if (NULL != window->scrollback)
+        scrollback_destroy(window->scrollback);
+    mem_free(MEM_TUI, window->lines, window->lines_capacity * sizeof(*window->lines));
+    mem_free(MEM_TUI, window->display, window->display_capacity * sizeof(*window->display));
+    mem_free(MEM_TUI, window, sizeof(*window));
 }
 
 /********************************************************************
@@ -617,33 +778,19 @@ void window_destroy(Window window)
  ********************************************************************/
 void screen_destroy(Screen screen)
 {
-    if (NULL == returned_ids)
-        returned_ids = stack_int_create();
-
-    stack_int_push(returned_ids, screen->id);
+    return_id(screen->id);
 
-    Node_ptr_to_window *p = screen->lowest;
-    Node_ptr_to_window *temp = NULL;
-
-    while (NULL != p)
+    for (int i = 0; i < screen->nodes_number; i++)
     {
-        window_remove_screen(p->window, screen);
-        temp = p;
-        p = p->next;
-        free(temp);
+        window_remove_screen(screen->nodes[i]->window, screen);
+        pool_free(window_nodes, screen->nodes[i]);
     }
 
-    if (NULL != screen->display_strings)
-    {
-        for (char **p = screen->display_strings;
-                p < screen->display_strings + (screen->changed ? screen->old_height : screen->height);
-                p++)
-        {
-            free(*p);
-        }
-        free(screen->display_strings);
-    }
-    free(screen);
+    mem_free(MEM_TUI, screen->nodes, screen->nodes_capacity * sizeof(*screen->nodes));
+    mem_free(MEM_TUI, screen->by_id, screen->by_id_capacity * sizeof(*screen->by_id));
+    mem_free(MEM_TUI, screen->display, screen->display_capacity * sizeof(*screen->display));
+    emitted_frame_free(&screen->emitted);
+    mem_free(MEM_TUI, screen, sizeof(*screen));
 }
 
 /********************************************************************
@@ -665,7 +812,7 @@ bool window_set_frame(Window window, char delim_hori, char delim_vert, char deli
     window->delim_vert = delim_vert;
     window->delim_corner = delim_corner;
 
-    window->changed = true;
+    window_mark_changed(window);
 
     return true;
 }
@@ -685,7 +832,7 @@ bool window_set_space(Window window, int top, int bot, int left, int right)
     window->space_left = left;
     window->space_right = right;
     
-    window->changed = true;
+    window_mark_changed(window);
 
     return true;
 }
@@ -697,7 +844,7 @@ bool window_set_space(Window window, int top, int bot, int left, int right)
  ********************************************************************/
 void window_display_frame(Window window, bool display)
 {
-    window->changed = true;
+    window_mark_changed(window);
 
     window->display_frame = display;
 }
@@ -712,11 +859,10 @@ bool window_set_size(Window window, int height, int width)
     if ((height < 0) || (width < 0))
         return false;
  
-    window->old_height = window->height;
     window->height = height;
     window->width = width;
 
-    window->changed = true;
+    window_mark_changed(window);
 
     return true;
 }
@@ -738,8 +884,9 @@ bool window_set_linebreak(Window window, Linebreak lb_mode)
         return false;
 
     window->content_lb_mode = lb_mode;
+    window->layout_width = -1;
 
-    window->changed = true;
+    window_mark_changed(window);
 
     return true;
 }
@@ -752,18 +899,14 @@ bool window_set_linebreak(Window window, Linebreak lb_mode)
  ********************************************************************/
 bool screen_window_set_position(Screen screen, Window window, int pos_hori, int pos_vert)
 {
-    Node_ptr_to_window *p = screen->lowest;
-    while (p != NULL)
-    {
-        if (p->window->id == window->id)
-        {
-            p->pos_hori = pos_hori;
-            p->pos_vert = pos_vert;
-            return true;
-        }
-        p = p->next;
-    }
-    return false;
+    Node_ptr_to_window *p = screen_find_node(screen, window);
+    if (NULL == p)
+        return false;
+
+    p->pos_hori = pos_hori;
+    p->pos_vert = pos_vert;
+    screen_mark_node(screen, p);
+    return true;
 }
 
 /********************************************************************
@@ -779,7 +922,7 @@ bool window_set_orientation(Window window, Orientation orientation)
 
     window->content_orientation = orientation;
 
-    window->changed = true;
+    window_mark_changed(window);
 
     return true;
 }
@@ -800,7 +943,7 @@ bool window_set_fill(Window window, char fill_line, char fill_border)
     window->fill_line = fill_line;
     window->fill_border = fill_border;
 
-    window->changed = true;
+    window_mark_changed(window);
 
     return true;
 }
@@ -818,24 +961,280 @@ bool window_update_content(Window window, char *content, int content_length)
     if (content_length < 0)
         return false;
 
-    // adjust window's content_length
-    if (content_length != window->content_length)
+    // content ends at the first '\0'
+    const char *end = memchr(content, '\0', content_length);
+    if (NULL != end)
+        content_length = end - content;
+
+    if (NULL != window->scrollback)
     {
-        window->content_length = content_length;
-        window->content = realloc(window->content, (window->content_length + 1) * sizeof(window->content));
-        MEM_TEST(window->content);
+        scrollback_clear(window->scrollback);
+        scrollback_append_utf8(window->scrollback, content, content_length);
+        window_mark_changed(window);
+        return true;
     }
 
-    // copying
-    for (int i = 0; i < content_length; i++)
-        window->content[i] = content[i];
-    window->content[content_length] = '\0';
+    // every byte is at most one cell
+    window_reserve_content(window, content_length);
+    const char *text = content;
+    window->content_length = utf8_to_cells(&text, &content_length, window->content, content_length);
+    window->content[window->content_length] = (Cell) {0, 0};
+    window->layout_width = -1;
 
-    window->changed = true;
+    window_mark_changed(window);
+
+    return true;
+}
+
+/********************************************************************
+ * window_update_cells: Copies cells up to the first one of code
+ *                      point 0.
+ ********************************************************************/
+bool window_update_cells(Window window, const Cell *cells, int length)
+{
+    if (length < 0)
+        return false;
+
+    for (int i = 0; i < length; i++)
+    {
+        if (0 == cells[i].codepoint)
+            length = i;
+    }
+
+    if (NULL != window->scrollback)
+    {
+        scrollback_clear(window->scrollback);
+        scrollback_append(window->scrollback, cells, length);
+        window_mark_changed(window);
+        return true;
+    }
+
+    window_reserve_content(window, length);
+    memcpy(window->content, cells, length * sizeof(*cells));
+    window->content_length = length;
+    window->content[length] = (Cell) {0, 0};
+    window->layout_width = -1;
+
+    window_mark_changed(window);
+
+    return true;
+}
+
+/********************************************************************
+ * window_set_style: Both colors have to be TUI_DEFAULT or a color
+ *                   of the palette, no bits above the attributes
+ *                   may be set.
+ ********************************************************************/
+bool window_set_style(Window window, uint32_t style)
+{
+    if ((0 != (style >> 24)) || (256 < (style & 0x1FF)) || (256 < ((style >> 9) & 0x1FF)))
+        return false;
+
+    window->style = style;
+
+    window_mark_changed(window);
+
+    return true;
+}
+
+/********************************************************************
+ * window_reserve_content: Makes window->content hold length cells
+ *                         and the one ending them. The old cells
+ *                         are not kept.
+ ********************************************************************/
+PRIVATE void window_reserve_content(Window window, int length)
+{
+    if (length + 1 <= window->content_capacity)
+        return;
+
+    mem_free(MEM_TUI, window->content, window->content_capacity * sizeof(*window->content));
+    window->content_capacity = length + 1;
+    window->content = mem_alloc(MEM_TUI, window->content_capacity * sizeof(*window->content));
+}
+
+/********************************************************************
+ * window_set_scrollback: A new scrollback window takes its content
+ *                        as its first lines and keeps only an empty
+ *                        string as content. Resizing the ring moves
+ *                        the newest lines (with their memory) into
+ *                        the new one and frees the others.
+ ********************************************************************/
+bool window_set_scrollback(Window window, int max_lines)
+{
+    if (0 >= max_lines)
+        return false;
+
+    Scrollback old = window->scrollback;
+    Scrollback scrollback = mem_alloc(MEM_TUI, sizeof(*scrollback));
+    scrollback->lines = mem_calloc(MEM_TUI, max_lines, sizeof(*scrollback->lines));
+    scrollback->capacity = max_lines;
+    scrollback->first = 0;
+    scrollback->number = 0;
+    scrollback->open = false;
+    scrollback->offset = 0;
+    scrollback->follow = true;
+    window->scrollback = scrollback;
+
+    if (NULL == old)
+    {
+        scrollback_append(scrollback, window->content, window->content_length);
+        window->content = mem_realloc(MEM_TUI, window->content, window->content_capacity * sizeof(*window->content),
+                                      sizeof(*window->content));
+        window->content_capacity = 1;
+        window->content_length = 0;
+        window->content[0] = (Cell) {0, 0};
+        window->layout_width = -1;
+    }
+    else
+    {
+        int kept = MIN(old->number, max_lines);
+        for (int i = 0; i < kept; i++)
+        {
+            Log_line *line = scrollback_line(old, old->number - kept + i);
+            scrollback->lines[i] = *line;
+            line->text = NULL;
+        }
+        scrollback->number = kept;
+        scrollback->open = old->open;
+        scrollback->offset = MIN(old->offset, MAX(kept - 1, 0));
+        scrollback->follow = old->follow;
+        scrollback_destroy(old);
+    }
+
+    window_mark_changed(window);
+    return true;
+}
+
+/********************************************************************
+ * window_append: Only the newest line is touched, appending never
+ *                copies the lines before it.
+ ********************************************************************/
+bool window_append(Window window, const char *text, int length)
+{
+    if ((NULL == window->scrollback) || (0 > length))
+        return false;
+
+    scrollback_append_utf8(window->scrollback, text, length);
+    window_mark_changed(window);
+    return true;
+}
+
+/********************************************************************
+ * window_scroll: Offsets beyond the oldest line are cut.
+ ********************************************************************/
+bool window_scroll(Window window, int lines)
+{
+    if ((NULL == window->scrollback) || (0 > lines))
+        return false;
+
+    window->scrollback->offset = MIN(lines, MAX(window->scrollback->number - 1, 0));
+    window_mark_changed(window);
+    return true;
+}
+
+/********************************************************************
+ * window_follow_tail: Turning follow on scrolls to the newest line.
+ ********************************************************************/
+bool window_follow_tail(Window window, bool follow)
+{
+    if (NULL == window->scrollback)
+        return false;
 
+    window->scrollback->follow = follow;
+    if (follow)
+        window->scrollback->offset = 0;
+    window_mark_changed(window);
     return true;
 }
 
+/********************************************************************
+ * scrollback_line: Returns the line at index, counted from the
+ *                  oldest line.
+ ********************************************************************/
+PRIVATE Log_line *scrollback_line(Scrollback scrollback, int index)
+{
+    return &scrollback->lines[(scrollback->first + index) % scrollback->capacity];
+}
+
+/********************************************************************
+ * scrollback_append: Appends cells to the newest line while it is
+ *                    open, every '\n' closes a line. A new line
+ *                    reuses the slot and the memory of the oldest
+ *                    line once the ring is full. Without follow the
+ *                    offset grows with every new line, so the view
+ *                    stays on the same lines.
+ ********************************************************************/
+PRIVATE void scrollback_append(Scrollback scrollback, const Cell *cells, int length)
+{
+    while (0 < length)
+    {
+        if (!scrollback->open)
+        {
+            if (scrollback->number < scrollback->capacity)
+                scrollback->number++;
+            else
+                scrollback->first = (scrollback->first + 1) % scrollback->capacity;
+            scrollback_line(scrollback, scrollback->number - 1)->length = 0;
+            scrollback->open = true;
+            scrollback->offset = scrollback->follow ? 0 : MIN(scrollback->offset + 1, scrollback->number - 1);
+        }
+
+        int segment = 0;
+        while ((segment < length) && ('\n' != cells[segment].codepoint))
+            segment++;
+        Log_line *line = scrollback_line(scrollback, scrollback->number - 1);
+        if (line->length + segment > line->capacity)
+        {
+            int capacity = MAX(2 * line->capacity, MAX(line->length + segment, 16));
+            line->text = mem_realloc(MEM_TUI, line->text, line->capacity * sizeof(*line->text),
+                                     capacity * sizeof(*line->text));
+            line->capacity = capacity;
+        }
+        memcpy(line->text + line->length, cells, segment * sizeof(*cells));
+        line->length += segment;
+
+        if (segment == length)
+            break;
+        scrollback->open = false;
+        cells += segment + 1;
+        length -= segment + 1;
+    }
+}
+
+/********************************************************************
+ * scrollback_append_utf8: Decodes text in pieces of a buffer on the
+ *                         stack and appends them.
+ ********************************************************************/
+PRIVATE void scrollback_append_utf8(Scrollback scrollback, const char *text, int length)
+{
+    Cell cells[256];
+    while (0 < length)
+        scrollback_append(scrollback, cells, utf8_to_cells(&text, &length, cells, 256));
+}
+
+/********************************************************************
+ * scrollback_clear: Removes all lines, keeping their memory.
+ ********************************************************************/
+PRIVATE void scrollback_clear(Scrollback scrollback)
+{
+    scrollback->first = 0;
+    scrollback->number = 0;
+    scrollback->open = false;
+    scrollback->offset = 0;
+}
+
+/********************************************************************
+ * scrollback_destroy: Frees the memory of all slots of the ring,
+ *                     not only of the lines in use.
+ ********************************************************************/
+PRIVATE void scrollback_destroy(Scrollback scrollback)
+{
+    for (int i = 0; i < scrollback->capacity; i++)
+        mem_free(MEM_TUI, scrollback->lines[i].text, scrollback->lines[i].capacity * sizeof(*scrollback->lines[i].text));
+    mem_free(MEM_TUI, scrollback->lines, scrollback->capacity * sizeof(*scrollback->lines));
+    mem_free(MEM_TUI, scrollback, sizeof(*scrollback));
+}
+
 /********************************************************************
  * window_duplicate: Returns a duplicate of a window.
  *                   The duplicate is an exact copy of the original.
@@ -859,6 +1258,7 @@ Window window_duplicate(Window window)
     // fillers
     duplicate_window->fill_line = window->fill_line;
     duplicate_window->fill_border = window->fill_border;
+    duplicate_window->style = window->style;
     // space at border (all >= 0)
     duplicate_window->space_top = window->space_top;
     duplicate_window->space_bot = window->space_bot;
@@ -867,16 +1267,28 @@ Window window_duplicate(Window window)
     // content variables
     duplicate_window->content_orientation = window->content_orientation;
     duplicate_window->content_lb_mode = window->content_lb_mode;
+    // +1 for the cell ending the content
+    window_reserve_content(duplicate_window, window->content_length);
+    memcpy(duplicate_window->content, window->content, (window->content_length + 1) * sizeof(*window->content));
     duplicate_window->content_length = window->content_length;
-    // +1 for '\0'
-    duplicate_window->content = malloc((duplicate_window->content_length + 1) * sizeof(*duplicate_window->content));
-    MEM_TEST(duplicate_window->content);
+    duplicate_window->layout_width = -1;
 
-    strcpy(duplicate_window->content, window->content);
+    if (NULL != window->scrollback)
+    {
+        window_set_scrollback(duplicate_window, window->scrollback->capacity);
+        for (int i = 0; i < window->scrollback->number; i++)
+        {
+            Log_line *line = scrollback_line(window->scrollback, i);
+            scrollback_append(duplicate_window->scrollback, line->text, line->length);
+            if ((i < window->scrollback->number - 1) || !window->scrollback->open)
+                scrollback_append(duplicate_window->scrollback, &(Cell) {'\n', 0}, 1);
+        }
+        duplicate_window->scrollback->offset = window->scrollback->offset;
+        duplicate_window->scrollback->follow = window->scrollback->follow;
+    }
 
-    duplicate_window->display_strings = window_make_strings(duplicate_window);
+    window_make_strings(duplicate_window);
     duplicate_window->changed = false;
-    duplicate_window->old_height = window->old_height;
 
     return duplicate_window;
 }
@@ -898,239 +1310,1162 @@ void window_print(Window window)
 {
     window_update_strings(window);
 
-    char **p = window->display_strings;
-    for (p = window->display_strings; p < window->display_strings + window->height; p++)
+    // styles are left out
+    for (int row = 0; row < window->height; row++)
     {
-        puts(*p);
+        for (int i = 0; i < window->width; i++)
+        {
+            char bytes[4];
+            fwrite(bytes, 1, utf8_encode(window->display[row * window->width + i].codepoint, bytes), stdout);
+        }
+        putchar('\n');
     }
 }
 
 /********************************************************************
  * screen_print: Updates a screen if necessary and then
- *               prints it.
+ *               writes the changes since the last frame to stdout
+ *               with a single write(2).
+ *               stdout is flushed first, so text printed before
+ *               does not end up after the frame.
  ********************************************************************/
 void screen_print(Screen screen)
 {
-    screen_update_strings(screen);
+    int length;
+    const char *output = screen_render(screen, &length);
 
-    char **p = screen->display_strings;
-    for (p = screen->display_strings; p < screen->display_strings + screen->height; p++)
+    if (0 < length)
     {
-        puts(*p);
+        fflush(stdout);
+        write_all(STDOUT_FILENO, output, length);
     }
 }
 
 /********************************************************************
- * window_update_strings: updates window->display_strings should
- *                        be called, before window gets printed
- *                        or written to a screen, if 
- *                        window->changed is true
+ * screen_render: Compares the screen with the last frame.
  ********************************************************************/
-PRIVATE void window_update_strings(Window window)
+const char *screen_render(Screen screen, int *length)
 {
-    if (window->changed)
-    {
-        for (char **p = window->display_strings; p < window->display_strings + window->old_height; p++)
-        {
-            free(*p);
-        }
-        free(window->display_strings);
+    screen_update_strings(screen);
+    emitted_frame_diff(&screen->emitted, screen->display, screen->height, screen->width, screen->frame_number);
+
+    *length = screen->emitted.output_length;
+    return screen->emitted.output;
+}
+
+/********************************************************************
+ * emitted_frame_diff: Writes the output turning emitted->frame into
+ *                     display, row by row, and makes display the
+ *                     new frame. A changed size redraws everything
+ *                     (after clearing the terminal, if there was a
+ *                     frame before). The cursor is left on the line
+ *                     below the screen.
+ *                     Rows are only compared if frame_number differs
+ *                     from the one of the last diffed frame, as
+ *                     display did not change otherwise.
+ ********************************************************************/
+PRIVATE void emitted_frame_diff(Emitted_frame *emitted, const Cell *display, int height, int width, unsigned long frame_number)
+{
+    emitted->output_length = 0;
+    emitted->style = 0;
+
+    bool full = (NULL == emitted->frame) || (emitted->height != height) || (emitted->width != width);
+    if (full)
+    {
+        if (NULL != emitted->frame)
+            output_append(emitted, "\x1b[2J", 4);
+        emitted_frame_free_frame(emitted);
+        emitted->frame = mem_alloc(MEM_TUI, ((size_t) height * width + 1) * sizeof(*emitted->frame));
+        emitted->height = height;
+        emitted->width = width;
+    }
+
+    bool updated = emitted->diffed != frame_number;
+    emitted->diffed = frame_number;
+
+    for (int row = 0; (full || updated) && (row < height); row++)
+        render_row(emitted, display + row * width, emitted->frame + row * width, full, row);
+
+    if (0 != emitted->style)
+        output_style(emitted, 0);
+
+    if (0 < emitted->output_length)
+        output_move_cursor(emitted, height, 0);
+}
+
+/********************************************************************
+ * emitted_frame_free_frame: Frees emitted->frame, so the next
+ *                           frame is written in full.
+ ********************************************************************/
+PRIVATE void emitted_frame_free_frame(Emitted_frame *emitted)
+{
+    if (NULL != emitted->frame)
+        mem_free(MEM_TUI, emitted->frame, ((size_t) emitted->height * emitted->width + 1) * sizeof(*emitted->frame));
+    emitted->frame = NULL;
+}
+
+/********************************************************************
+ * emitted_frame_free: Frees the frame and the output of emitted.
+ ********************************************************************/
+PRIVATE void emitted_frame_free(Emitted_frame *emitted)
+{
+    emitted_frame_free_frame(emitted);
+    mem_free(MEM_TUI, emitted->output, emitted->output_capacity);
+    emitted->output = NULL;
+    emitted->output_capacity = 0;
+}
+
+/********************************************************************
+ * screen_invalidate: Forgets the last frame.
+ ********************************************************************/
+void screen_invalidate(Screen screen)
+{
+    emitted_frame_free_frame(&screen->emitted);
+}
+
+/********************************************************************
+ * renderer_create: Starts the thread writing to fd.
+ ********************************************************************/
+Renderer renderer_create(int fd)
+{
+    Renderer renderer = mem_alloc(MEM_TUI, sizeof(*renderer));
+    renderer->fd = fd;
+    renderer->pending = NULL;
+    renderer->pending_capacity = 0;
+    renderer->pending_height = 0;
+    renderer->pending_width = 0;
+    renderer->pending_ready = false;
+    renderer->working = NULL;
+    renderer->working_capacity = 0;
+    renderer->working_height = 0;
+    renderer->working_width = 0;
+    renderer->busy = false;
+    renderer->stop = false;
+    renderer->frames_published = 0;
+    renderer->frames_written = 0;
+    renderer->emitted = (Emitted_frame) {NULL, 0, 0, NULL, 0, 0, 0, 0};
+
+    pthread_mutex_init(&renderer->mutex, NULL);
+    pthread_cond_init(&renderer->published, NULL);
+    pthread_cond_init(&renderer->written, NULL);
+    if (0 != pthread_create(&renderer->thread, NULL, renderer_thread, renderer))
+    {
+        pthread_cond_destroy(&renderer->written);
+        pthread_cond_destroy(&renderer->published);
+        pthread_mutex_destroy(&renderer->mutex);
+        mem_free(MEM_TUI, renderer, sizeof(*renderer));
+        return NULL;
+    }
+    return renderer;
+}
+
+/********************************************************************
+ * renderer_destroy: Lets the thread write the pending frame, then
+ *                   stops it.
+ ********************************************************************/
+void renderer_destroy(Renderer renderer)
+{
+    pthread_mutex_lock(&renderer->mutex);
+    renderer->stop = true;
+    pthread_cond_signal(&renderer->published);
+    pthread_mutex_unlock(&renderer->mutex);
+    pthread_join(renderer->thread, NULL);
+
+    pthread_cond_destroy(&renderer->written);
+    pthread_cond_destroy(&renderer->published);
+    pthread_mutex_destroy(&renderer->mutex);
+    mem_free(MEM_TUI, renderer->pending, renderer->pending_capacity * sizeof(*renderer->pending));
+    mem_free(MEM_TUI, renderer->working, renderer->working_capacity * sizeof(*renderer->working));
+    emitted_frame_free(&renderer->emitted);
+    mem_free(MEM_TUI, renderer, sizeof(*renderer));
+}
+
+/********************************************************************
+ * renderer_publish: Composites screen on the calling thread, only
+ *                   the copy into the pending buffer is locked.
+ *                   A pending frame the thread did not take yet is
+ *                   overwritten (coalesced).
+ ********************************************************************/
+void renderer_publish(Renderer renderer, Screen screen)
+{
+    screen_update_strings(screen);
+    int size = screen->height * screen->width;
+
+    pthread_mutex_lock(&renderer->mutex);
+    display_reserve(&renderer->pending, &renderer->pending_capacity, size);
+    if (0 < size)
+        memcpy(renderer->pending, screen->display, size * sizeof(*screen->display));
+    renderer->pending_height = screen->height;
+    renderer->pending_width = screen->width;
+    renderer->pending_ready = true;
+    renderer->frames_published++;
+    pthread_cond_signal(&renderer->published);
+    pthread_mutex_unlock(&renderer->mutex);
+}
+
+/********************************************************************
+ * renderer_flush: Waits until the thread is idle.
+ ********************************************************************/
+void renderer_flush(Renderer renderer)
+{
+    pthread_mutex_lock(&renderer->mutex);
+    while (renderer->pending_ready || renderer->busy)
+        pthread_cond_wait(&renderer->written, &renderer->mutex);
+    pthread_mutex_unlock(&renderer->mutex);
+}
+
+/********************************************************************
+ * renderer_statistics: Writes the number of published and of
+ *                      written frames.
+ ********************************************************************/
+void renderer_statistics(Renderer renderer, long *published, long *written)
+{
+    pthread_mutex_lock(&renderer->mutex);
+    *published = renderer->frames_published;
+    *written = renderer->frames_written;
+    pthread_mutex_unlock(&renderer->mutex);
+}
 
-        window->display_strings = window_make_strings(window);
+/********************************************************************
+ * renderer_thread: Swaps the pending and the working buffer, then
+ *                  diffs and writes the working frame without
+ *                  holding the lock, so publishing never waits for
+ *                  the terminal.
+ ********************************************************************/
+PRIVATE void *renderer_thread(void *argument)
+{
+    Renderer renderer = argument;
+
+    pthread_mutex_lock(&renderer->mutex);
+    while (true)
+    {
+        while (!renderer->pending_ready && !renderer->stop)
+            pthread_cond_wait(&renderer->published, &renderer->mutex);
+        if (!renderer->pending_ready)
+            break;
+
+        Cell *swap = renderer->working;
+        renderer->working = renderer->pending;
+        renderer->pending = swap;
+        int swap_capacity = renderer->working_capacity;
+        renderer->working_capacity = renderer->pending_capacity;
+        renderer->pending_capacity = swap_capacity;
+        renderer->working_height = renderer->pending_height;
+        renderer->working_width = renderer->pending_width;
+        renderer->pending_ready = false;
+        renderer->busy = true;
+        // every frame taken is new to the thread
+        unsigned long frame_number = renderer->frames_written + 1;
+        pthread_mutex_unlock(&renderer->mutex);
+
+        emitted_frame_diff(&renderer->emitted, renderer->working,
+                           renderer->working_height, renderer->working_width, frame_number);
+        if (0 < renderer->emitted.output_length)
+            write_all(renderer->fd, renderer->emitted.output, renderer->emitted.output_length);
+
+        pthread_mutex_lock(&renderer->mutex);
+        renderer->busy = false;
+        renderer->frames_written++;
+        pthread_cond_broadcast(&renderer->written);
+    }
+    pthread_mutex_unlock(&renderer->mutex);
+    return NULL;
+}
+
+/********************************************************************
+ * window_update_strings: updates window->display should
+ *                        be called, before window gets printed
+ *                        or written to a screen, if
+ *                        window->changed is true
+ ********************************************************************/
+PRIVATE void window_update_strings(Window window)
+{
+    if (window->changed)
+    {
+        window_make_strings(window);
         window->changed = false;
     }
 }
 
-PRIVATE void screen_update_strings(Screen screen)
+/********************************************************************
+ * window_mark_changed: Has to be called on every change of window
+ *                      which changes its display.
+ *                      window->changed tells window_update_strings()
+ *                      to make the display again, every screen
+ *                      containing window marks the rectangles it
+ *                      covered and covers now as dirty.
+ ********************************************************************/
+PRIVATE void window_mark_changed(Window window)
 {
-    if (screen->changed)
+    window->changed = true;
+    for (Node_ptr_to_screen *p = window->screens->first; NULL != p; p = p->next)
+        screen_mark_node(p->screen, screen_find_node(p->screen, window));
+}
+
+/********************************************************************
+ * screen_mark_node: Marks the rectangle node was drawn at and the
+ *                   one it covers now as dirty.
+ ********************************************************************/
+PRIVATE void screen_mark_node(Screen screen, Node_ptr_to_window *node)
+{
+    Rect rect = node_rect(node);
+    screen_mark_dirty(screen, node->drawn);
+    screen_mark_dirty(screen, rect);
+    node->drawn = rect;
+}
+
+/********************************************************************
+ * screen_find_node: Returns the node of screen pointing to window,
+ *                   NULL if there is none.
+ ********************************************************************/
+PRIVATE Node_ptr_to_window *screen_find_node(Screen screen, Window window)
+{
+    if (0 == screen->nodes_number)
+        return NULL;
+
+    unsigned int slot = by_id_slot(screen, window->id);
+    while (NULL != screen->by_id[slot])
+    {
+        if (screen->by_id[slot]->window->id == window->id)
+            return screen->by_id[slot];
+        slot = (slot + 1) & (screen->by_id_capacity - 1);
+    }
+    return NULL;
+}
+
+/********************************************************************
+ * screen_node_index: Returns the index of the first node with a
+ *                    stored priority >= priority (nodes_number if
+ *                    there is none).
+ ********************************************************************/
+PRIVATE int screen_node_index(Screen screen, long long priority)
+{
+    int low = 0;
+    int high = screen->nodes_number;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (screen->nodes[middle]->priority < priority)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/********************************************************************
+ * screen_insert_node: Inserts node at index into screen->nodes,
+ *                     growing the array if necessary.
+ ********************************************************************/
+PRIVATE void screen_insert_node(Screen screen, Node_ptr_to_window *node, int index)
+{
+    if (screen->nodes_number == screen->nodes_capacity)
+    {
+        int capacity = MAX(2 * screen->nodes_capacity, 8);
+        screen->nodes = mem_realloc(MEM_TUI, screen->nodes, screen->nodes_capacity * sizeof(*screen->nodes),
+                                    capacity * sizeof(*screen->nodes));
+        screen->nodes_capacity = capacity;
+    }
+    memmove(screen->nodes + index + 1, screen->nodes + index,
+            (screen->nodes_number - index) * sizeof(*screen->nodes));
+    screen->nodes[index] = node;
+    screen->nodes_number++;
+}
+
+/********************************************************************
+ * screen_erase_node: Removes the node at index from screen->nodes.
+ ********************************************************************/
+PRIVATE void screen_erase_node(Screen screen, int index)
+{
+    screen->nodes_number--;
+    memmove(screen->nodes + index, screen->nodes + index + 1,
+            (screen->nodes_number - index) * sizeof(*screen->nodes));
+}
+
+/********************************************************************
+ * screen_unlink_node: Removes node from screen->nodes and
+ *                     screen->by_id without freeing it.
+ ********************************************************************/
+PRIVATE void screen_unlink_node(Screen screen, Node_ptr_to_window *node)
+{
+    by_id_remove(screen, node);
+    screen_erase_node(screen, screen_node_index(screen, node->priority));
+}
+
+/********************************************************************
+ * by_id_insert: Adds node to screen->by_id, which is doubled and
+ *               filled again when it would get more than half full.
+ ********************************************************************/
+PRIVATE void by_id_insert(Screen screen, Node_ptr_to_window *node)
+{
+    // node is already in screen->nodes
+    if (2 * screen->nodes_number > screen->by_id_capacity)
     {
-        if (NULL != screen->display_strings)
+        mem_free(MEM_TUI, screen->by_id, screen->by_id_capacity * sizeof(*screen->by_id));
+        screen->by_id_capacity = MAX(2 * screen->by_id_capacity, 16);
+        screen->by_id = mem_calloc(MEM_TUI, screen->by_id_capacity, sizeof(*screen->by_id));
+        for (int i = 0; i < screen->nodes_number; i++)
         {
-            for (char **p = screen->display_strings; p < screen->display_strings + screen->old_height; p++)
-            {
-                free(*p);
-            }
-            free(screen->display_strings);
+            if (screen->nodes[i] != node)
+                by_id_insert(screen, screen->nodes[i]);
         }
+    }
 
-        screen->display_strings = screen_make_strings(screen);
-        screen->changed = false;
+    unsigned int slot = by_id_slot(screen, node->window->id);
+    while (NULL != screen->by_id[slot])
+        slot = (slot + 1) & (screen->by_id_capacity - 1);
+    screen->by_id[slot] = node;
+}
+
+/********************************************************************
+ * by_id_remove: Removes node from screen->by_id. The following
+ *               entries of the probe sequence are moved back, so no
+ *               search stops too early.
+ ********************************************************************/
+PRIVATE void by_id_remove(Screen screen, Node_ptr_to_window *node)
+{
+    unsigned int mask = screen->by_id_capacity - 1;
+    unsigned int slot = by_id_slot(screen, node->window->id);
+    while (screen->by_id[slot] != node)
+        slot = (slot + 1) & mask;
+
+    unsigned int hole = slot;
+    for (slot = (slot + 1) & mask; NULL != screen->by_id[slot]; slot = (slot + 1) & mask)
+    {
+        // an entry can fill the hole, if the hole lies between its home slot and its slot
+        unsigned int home = by_id_slot(screen, screen->by_id[slot]->window->id);
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            screen->by_id[hole] = screen->by_id[slot];
+            hole = slot;
+        }
     }
+    screen->by_id[hole] = NULL;
 }
 
-PRIVATE char **screen_make_strings(Screen screen)
+/********************************************************************
+ * by_id_slot: Returns the home slot of id in screen->by_id.
+ ********************************************************************/
+PRIVATE unsigned int by_id_slot(Screen screen, int id)
 {
-    char **screen_rows = malloc(screen->height * sizeof(*screen_rows));
-    MEM_TEST(screen_rows);
+    return ((unsigned int) id * 2654435761u) & (screen->by_id_capacity - 1);
+}
 
-    char **screen_current_row;
-    char *screen_current_col;
-    for (screen_current_row = screen_rows;
-         screen_current_row < screen_rows + screen->height;
-         screen_current_row++)
+/********************************************************************
+ * screen_update_strings: Composites the dirty rectangles again and
+ *                        counts the new frame in
+ *                        screen->frame_number.
+ *                        Returns false if nothing was composited.
+ ********************************************************************/
+PRIVATE bool screen_update_strings(Screen screen)
+{
+    if (screen->changed)
     {
-        *screen_current_row = malloc((screen->width + 1) * sizeof(**screen_current_row));
-        MEM_TEST(*screen_current_row);
+        display_reserve(&screen->display, &screen->display_capacity, screen->height * screen->width);
+        screen_make_strings(screen, (Rect) {0, 0, screen->height, screen->width});
+        screen->changed = false;
+        screen->dirty_number = 0;
+        screen->frame_number++;
+        return true;
+    }
+
+    if (0 == screen->dirty_number)
+        return false;
+
+    for (int i = 0; i < screen->dirty_number; i++)
+        screen_make_strings(screen, screen->dirty[i]);
+    screen->dirty_number = 0;
+    screen->frame_number++;
+    return true;
+}
 
-        for (screen_current_col = *screen_current_row;
-             screen_current_col < *screen_current_row + screen->width;
-             screen_current_col++)
-            *screen_current_col = screen->background;
+/********************************************************************
+ * screen_mark_dirty: Adds the part of rect, which lies on screen,
+ *                    to the dirty rectangles of screen.
+ *                    Rectangles overlapping or touching rect are
+ *                    merged with it, so no part of the screen is
+ *                    composited twice. If there are too many
+ *                    rectangles, they are merged into one.
+ ********************************************************************/
+PRIVATE void screen_mark_dirty(Screen screen, Rect rect)
+{
+    rect = rect_intersection(rect, (Rect) {0, 0, screen->height, screen->width});
+    if (screen->changed || rect_empty(rect))
+        return;
 
-        *screen_current_col = '\0';
+    int i = 0;
+    while (i < screen->dirty_number)
+    {
+        if (rect_touching(screen->dirty[i], rect))
+        {
+            // the union can touch rectangles which were checked before
+            rect = rect_union(rect, screen->dirty[i]);
+            screen->dirty[i] = screen->dirty[--screen->dirty_number];
+            i = 0;
+        }
+        else
+            i++;
     }
 
-    int window_beg_row;         // the first row in windows strings which will be displayed on screen
-    int screen_beg_row;         // the first row in screen strings on which will be written
-    int screen_end_row;         // the last row in screen strings on which will be written
-    int window_beg_col;         // the first column in windows strings which will be displayed on screen
-    int screen_beg_col;         // the first column in screen strings on which will be written
-    int screen_end_col;         // the last column in screen strings on which will be written
+    if (SCREEN_DIRTY_RECTS == screen->dirty_number)
+    {
+        for (i = 0; i < screen->dirty_number; i++)
+            rect = rect_union(rect, screen->dirty[i]);
+        screen->dirty_number = 0;
+    }
+    screen->dirty[screen->dirty_number++] = rect;
+}
 
-    char **window_current_row;
-    char *window_current_col;
-    
-    Node_ptr_to_window *p = screen->lowest;
-    while (NULL != p)
+/********************************************************************
+ * node_rect: Returns the rectangle covered by the window of node.
+ ********************************************************************/
+PRIVATE Rect node_rect(const Node_ptr_to_window *node)
+{
+    return (Rect) {node->pos_hori, node->pos_vert, node->window->height, node->window->width};
+}
+
+/********************************************************************
+ * rect_intersection: Returns the rectangle covered by a and b.
+ *                    Returns an empty rectangle at (0, 0) if they
+ *                    do not overlap, so the result always fits
+ *                    into an int.
+ ********************************************************************/
+PRIVATE Rect rect_intersection(Rect a, Rect b)
+{
+    // windows can be placed anywhere, so the ends can lie beyond INT_MAX
+    long long row = MAX(a.row, b.row);
+    long long column = MAX(a.column, b.column);
+    long long height = MIN((long long) a.row + a.height, (long long) b.row + b.height) - row;
+    long long width = MIN((long long) a.column + a.width, (long long) b.column + b.width) - column;
+    if ((0 >= height) || (0 >= width))
+        return (Rect) {0, 0, 0, 0};
+    return (Rect) {row, column, height, width};
+}
+
+/********************************************************************
+ * rect_empty: Checks if rect covers no characters.
+ ********************************************************************/
+PRIVATE bool rect_empty(Rect rect)
+{
+    return (0 >= rect.height) || (0 >= rect.width);
+}
+
+/********************************************************************
+ * rect_touching: Checks if a and b overlap or share an edge.
+ ********************************************************************/
+PRIVATE bool rect_touching(Rect a, Rect b)
+{
+    return (a.row <= (long long) b.row + b.height) && (b.row <= (long long) a.row + a.height)
+        && (a.column <= (long long) b.column + b.width) && (b.column <= (long long) a.column + a.width);
+}
+
+/********************************************************************
+ * rect_contains: Checks if inner lies completely inside of outer.
+ ********************************************************************/
+PRIVATE bool rect_contains(Rect outer, Rect inner)
+{
+    return (outer.row <= inner.row) && (outer.column <= inner.column)
+        && ((long long) inner.row + inner.height <= (long long) outer.row + outer.height)
+        && ((long long) inner.column + inner.width <= (long long) outer.column + outer.width);
+}
+
+/********************************************************************
+ * rect_union: Returns the smallest rectangle covering a and b.
+ *             Only used for rectangles on a screen.
+ ********************************************************************/
+PRIVATE Rect rect_union(Rect a, Rect b)
+{
+    int row = MIN(a.row, b.row);
+    int column = MIN(a.column, b.column);
+    return (Rect) {row, column,
+                   MAX(a.row + a.height, b.row + b.height) - row,
+                   MAX(a.column + a.width, b.column + b.width) - column};
+}
+
+/********************************************************************
+ * display_reserve: Makes *display hold at least size cells.
+ *                  Only reallocates if it has to grow, the old
+ *                  cells are not kept.
+ ********************************************************************/
+PRIVATE void display_reserve(Cell **display, int *capacity, int size)
+{
+    if ((NULL != *display) && (size <= *capacity))
+        return;
+
+    mem_free(MEM_TUI, *display, *capacity * sizeof(**display));
+    *capacity = MAX(size, 1);
+    *display = mem_alloc(MEM_TUI, *capacity * sizeof(**display));
+}
+
+/********************************************************************
+ * screen_make_strings: Composites rect (which has to lie on
+ *                      screen) again: fills it with the background
+ *                      and copies the parts of all windows
+ *                      overlapping it, lowest priority first.
+ *                      Everything below the highest window covering
+ *                      all of rect would be overwritten anyway, so
+ *                      compositing starts there. Windows not
+ *                      overlapping rect cost one comparison, so a
+ *                      call takes at most one pass over the windows
+ *                      plus one copy per character of rect and
+ *                      visible window layer.
+ ********************************************************************/
+PRIVATE void screen_make_strings(Screen screen, Rect rect)
+{
+    int first = screen->nodes_number - 1;
+    while ((0 <= first) && !rect_contains(node_rect(screen->nodes[first]), rect))
+        first--;
+
+    if (0 > first)
     {
-        if ((p->pos_hori > (screen->height - 1))
-         || (p->pos_vert > (screen->width - 1))
-         || (p->pos_hori + p->window->height - 1 < 0)
-         || (p->pos_vert + p->window->width - 1 < 0))
+        first = 0;
+        Cell background = {(unsigned char) screen->background, 0};
+        for (int row = rect.row; row < rect.row + rect.height; row++)
+        {
+            Cell *cell = screen->display + row * screen->width + rect.column;
+            for (int i = 0; i < rect.width; i++)
+                cell[i] = background;
+        }
+    }
+
+    for (int i = first; i < screen->nodes_number; i++)
+    {
+        Node_ptr_to_window *p = screen->nodes[i];
+        Rect part = rect_intersection(rect, node_rect(p));
+        if (rect_empty(part))
             continue;
 
         window_update_strings(p->window);
 
-        window_beg_row = (p->pos_hori >= 0) ? 0 : -(p->pos_hori);
-        window_beg_col = (p->pos_vert >= 0) ? 0 : -(p->pos_vert);
-        screen_beg_row = (p->pos_hori >= 0) ? p->pos_hori : 0;
-        screen_beg_col = (p->pos_vert >= 0) ? p->pos_vert : 0;
-        screen_end_row = MIN(p->pos_hori + p->window->height - 1, screen->height - 1);
-        screen_end_col = MIN(p->pos_vert + p->window->width - 1, screen->width - 1);
-
-        // fill in window
-        for (screen_current_row = screen_rows + screen_beg_row,
-             window_current_row = p->window->display_strings + window_beg_row;
-             screen_current_row <= screen_rows + screen_end_row;
-             screen_current_row++, window_current_row++)
+        // fill in window, one row at a time
+        for (int row = part.row; row < part.row + part.height; row++)
         {
-            for (screen_current_col = *screen_current_row + screen_beg_col,
-                 window_current_col = *window_current_row + window_beg_col;
-                 screen_current_col <= *screen_current_row + screen_end_col;
-                 screen_current_col++, window_current_col++)
-            {
-                *screen_current_col = *window_current_col;
-            }
+            memcpy(screen->display + row * screen->width + part.column,
+                   p->window->display + (row - p->pos_hori) * p->window->width + (part.column - p->pos_vert),
+                   part.width * sizeof(*screen->display));
+        }
+    }
+}
+
+/********************************************************************
+ * render_row: Appends the runs of current, which differ from
+ *             previous, to emitted->output and copies current
+ *             to previous. full writes the whole row.
+ ********************************************************************/
+PRIVATE void render_row(Emitted_frame *emitted, const Cell *current, Cell *previous, bool full, int row)
+{
+    if (full)
+    {
+        output_move_cursor(emitted, row, 0);
+        output_cells(emitted, current, emitted->width);
+        memcpy(previous, current, emitted->width * sizeof(*current));
+        return;
+    }
+
+    int column = 0;
+    while (column < emitted->width)
+    {
+        if (cells_equal(current[column], previous[column]))
+        {
+            column++;
+            continue;
+        }
+
+        // extend the run over short gaps of unchanged cells
+        int last_changed = column;
+        for (int i = column + 1; (i < emitted->width) && (i - last_changed <= DIFF_MAX_GAP); i++)
+        {
+            if (!cells_equal(current[i], previous[i]))
+                last_changed = i;
+        }
+
+        output_move_cursor(emitted, row, column);
+        output_cells(emitted, current + column, last_changed + 1 - column);
+        memcpy(previous + column, current + column, (last_changed + 1 - column) * sizeof(*current));
+        column = last_changed + 1;
+    }
+}
+
+PRIVATE bool cells_equal(Cell a, Cell b)
+{
+    return (a.codepoint == b.codepoint) && (a.style == b.style);
+}
+
+/********************************************************************
+ * output_append: Appends length bytes to emitted->output, growing
+ *                it if necessary.
+ ********************************************************************/
+PRIVATE void output_append(Emitted_frame *emitted, const char *bytes, int length)
+{
+    output_reserve(emitted, length);
+    memcpy(emitted->output + emitted->output_length, bytes, length);
+    emitted->output_length += length;
+}
+
+/********************************************************************
+ * output_reserve: Makes room for length more bytes in
+ *                 emitted->output.
+ ********************************************************************/
+PRIVATE void output_reserve(Emitted_frame *emitted, int length)
+{
+    if (emitted->output_length + length > emitted->output_capacity)
+    {
+        int capacity = MAX(2 * emitted->output_capacity, emitted->output_length + length);
+        emitted->output = mem_realloc(MEM_TUI, emitted->output, emitted->output_capacity, capacity);
+        emitted->output_capacity = capacity;
+    }
+}
+
+/********************************************************************
+ * output_cells: Appends cells encoded as UTF-8. A run of cells of
+ *               the same style is preceded by one SGR sequence, and
+ *               only if the terminal draws with another style.
+ ********************************************************************/
+PRIVATE void output_cells(Emitted_frame *emitted, const Cell *cells, int length)
+{
+    output_reserve(emitted, 4 * length);
+    for (int i = 0; i < length; i++)
+    {
+        if (cells[i].style != emitted->style)
+        {
+            output_style(emitted, cells[i].style);
+            output_reserve(emitted, 4 * (length - i));
+        }
+        emitted->output_length += utf8_encode(cells[i].codepoint, emitted->output + emitted->output_length);
+    }
+}
+
+/********************************************************************
+ * output_style: Appends the SGR sequence making the terminal draw
+ *               with style, starting from the defaults.
+ ********************************************************************/
+PRIVATE void output_style(Emitted_frame *emitted, uint32_t style)
+{
+    // "\x1b[0" + 6 attributes + 2 colors + "m"
+    char sequence[3 + 6 * 2 + 2 * 11 + 1];
+    char *end = sequence;
+    memcpy(end, "\x1b[0", 3);
+    end += 3;
+
+    static const struct {
+        uint32_t attribute;
+        char code;
+    } attributes[] = {{TUI_BOLD, '1'}, {TUI_DIM, '2'}, {TUI_ITALIC, '3'},
+                      {TUI_UNDERLINE, '4'}, {TUI_BLINK, '5'}, {TUI_REVERSE, '7'}};
+    for (unsigned i = 0; i < sizeof(attributes) / sizeof(*attributes); i++)
+    {
+        if (style & attributes[i].attribute)
+        {
+            *end++ = ';';
+            *end++ = attributes[i].code;
         }
-        
-        p = p->next;
     }
+    output_color(&end, (int) (style & 0x1FF) - 1, 30, 90, 38);
+    output_color(&end, (int) ((style >> 9) & 0x1FF) - 1, 40, 100, 48);
+    *end++ = 'm';
+
+    output_append(emitted, sequence, end - sequence);
+    emitted->style = style;
+}
 
-    return screen_rows;
+/********************************************************************
+ * output_color: Writes the SGR parameter for color to *sequence:
+ *               base + color for the first 8 colors, bright_base +
+ *               color - 8 for the next 8, palette;5;color for the
+ *               others. Nothing for TUI_DEFAULT.
+ ********************************************************************/
+PRIVATE void output_color(char **sequence, int color, int base, int bright_base, int palette)
+{
+    if (0 > color)
+        return;
+    if (8 > color)
+        *sequence += sprintf(*sequence, ";%d", base + color);
+    else if (16 > color)
+        *sequence += sprintf(*sequence, ";%d", bright_base + color - 8);
+    else
+        *sequence += sprintf(*sequence, ";%d;5;%d", palette, color);
 }
 
-PRIVATE char **window_make_strings(Window window)
+/********************************************************************
+ * output_move_cursor: Appends the ANSI sequence moving the cursor
+ *                     to (row, column), both counted from 0.
+ ********************************************************************/
+PRIVATE void output_move_cursor(Emitted_frame *emitted, int row, int column)
 {
-    char **rows = malloc(window->height * sizeof(*rows));
-    MEM_TEST(rows);
+    char sequence[32];
+    int length = snprintf(sequence, sizeof(sequence), "\x1b[%d;%dH", row + 1, column + 1);
+    output_append(emitted, sequence, length);
+}
 
-    char **current_row;
-    for (current_row = rows; current_row < rows + window->height; current_row++)
+/********************************************************************
+ * write_all: Writes all length bytes to fd, continuing after
+ *            interrupts and partial writes.
+ *            Returns false on errors.
+ ********************************************************************/
+PRIVATE bool write_all(int fd, const char *bytes, int length)
+{
+    while (0 < length)
     {
-        *current_row = malloc((window->width + 1) * sizeof(**current_row));
-        MEM_TEST(*current_row);
+        ssize_t written = write(fd, bytes, length);
+        if (0 > written)
+        {
+            if (EINTR == errno)
+                continue;
+            return false;
+        }
+        bytes += written;
+        length -= written;
     }
+    return true;
+}
 
-    bool content_end = false;
-    bool write = true;
-    char *p = window->content;
-    int i;
+/********************************************************************
+ * window_make_strings: Draws the frame and the borders, then the
+ *                      display lines of the content (see
+ *                      window_layout()), cut at the content area
+ *                      and placed by content_orientation.
+ ********************************************************************/
+PRIVATE void window_make_strings(Window window)
+{
+    display_reserve(&window->display, &window->display_capacity, window->height * window->width);
 
     int top_space = window->space_top + window->display_frame;
     int bot_space = window->space_bot + window->display_frame;
     int left_space = window->space_left + window->display_frame;
     int right_space = window->space_right + window->display_frame;
+    int area_width = window->width - left_space - right_space;
+
+    if (NULL != window->scrollback)
+        window_layout_scrollback(window, area_width, window->height - top_space - bot_space);
+    else
+        window_layout(window, area_width);
 
-    for (current_row = rows; current_row < rows + window->height; current_row++)
+    for (int row = 0; row < window->height; row++)
     {
-        write = true;
-        for (i = 0; i < window->width; i++)
+        Cell *current_row = window->display + row * window->width;
+        for (int i = 0; i < window->width; i++)
         {
-            if ((current_row <= rows + top_space - 1)
-             || (current_row >= rows + window->height - bot_space)
+            if ((row <= top_space - 1)
+             || (row >= window->height - bot_space)
              || (i <= left_space - 1)
              || (i >= window->width - right_space))
             {
                 if (window->display_frame)
                 {
-                    if ((current_row == rows) || (current_row == rows + window->height - 1))
+                    if ((0 == row) || (window->height - 1 == row))
                     {
                         if ((0 == i) || (window->width - 1 == i))
                         {
-                            (*current_row)[i] = window->delim_corner;
+                            current_row[i] = (Cell) {(unsigned char) window->delim_corner, window->style};
                             continue;
                         }
                         else
                         {
-                            (*current_row)[i] = window->delim_hori;
+                            current_row[i] = (Cell) {(unsigned char) window->delim_hori, window->style};
                             continue;
                         }
                     }
                     else if ((0 == i) || (window->width - 1 == i))
                     {
-                        (*current_row)[i] = window->delim_vert;
+                        current_row[i] = (Cell) {(unsigned char) window->delim_vert, window->style};
                         continue;
                     }
                 }
-                (*current_row)[i] = window->fill_border;
+                current_row[i] = (Cell) {(unsigned char) window->fill_border, window->style};
             }
+            else
+                current_row[i] = (Cell) {(unsigned char) window->fill_line, window->style};
+        }
 
-            // there needs to be window->display_mode  normal | truncate | smart 
-            // implement it with typedef enum
-            // the following implements normal
-            
-            else if (write && !content_end)
+        int line = row - top_space;
+        if ((0 >= area_width) || (0 > line) || (row >= window->height - bot_space) || (line >= window->lines_number))
+            continue;
+
+        Line_span span = window->lines[line];
+        int length = MIN(span.length, area_width);
+        int offset = 0;
+        if (CENTER_i == window->content_orientation)
+            offset = (area_width - length) / 2;
+        else if (RIGHT_i == window->content_orientation)
+            offset = area_width - length;
+        for (int i = 0; i < length; i++)
+        {
+            Cell cell = span.text[i];
+            if (0 == cell.style)
+                cell.style = window->style;
+            current_row[left_space + offset + i] = cell;
+        }
+    }
+}
+
+/********************************************************************
+ * window_layout: Breaks content into display lines for a content
+ *                area of width characters, unless the lines from
+ *                the last call still hold (see
+ *                window_layout_valid()).
+ *                Content ends at the first cell of code point 0.
+ *                LB_NORMAL:   A line continues on the next display
+ *                             line after width characters. A line
+ *                             of a multiple of width characters
+ *                             followed by '\n' is followed by an
+ *                             empty display line.
+ *                LB_TRUNCATE: Every line is one display line, cut
+ *                             by window_make_strings().
+ *                LB_SMART:    A line is broken at the last space
+ *                             which lets the words before it fit
+ *                             (the space is dropped), or after
+ *                             width characters if a word is longer.
+ ********************************************************************/
+PRIVATE void window_layout(Window window, int width)
+{
+    if (window_layout_valid(window, width))
+        return;
+
+    window->lines_number = 0;
+    window->layout_width = MAX(width, 0);
+    window->layout_longest = 0;
+
+    const Cell *content = window->content;
+    int start = 0;
+    while (0 != content[start].codepoint)
+    {
+        int end = start;
+        while ((0 != content[end].codepoint) && ('\n' != content[end].codepoint))
+            end++;
+        window->layout_longest = MAX(window->layout_longest, end - start);
+        window_break_line(window, content + start, end - start, '\n' == content[end].codepoint, width);
+        start = ('\n' == content[end].codepoint) ? end + 1 : end;
+    }
+}
+
+/********************************************************************
+ * window_layout_valid: The lines of LB_TRUNCATE do not depend on
+ *                      the width. The other modes only break lines
+ *                      longer than the width, so their lines stay
+ *                      the same for all widths above the longest
+ *                      line.
+ ********************************************************************/
+PRIVATE bool window_layout_valid(Window window, int width)
+{
+    if (0 > window->layout_width)
+        return false;
+    if (LB_TRUNCATE_i == window->content_lb_mode)
+        return true;
+    width = MAX(width, 0);
+    return (width == window->layout_width)
+        || ((window->layout_longest < window->layout_width) && (window->layout_longest < width));
+}
+
+/********************************************************************
+ * window_break_line: Adds the display lines of the length
+ *                    cells of text, which are followed by '\n'
+ *                    if newline is true.
+ ********************************************************************/
+PRIVATE void window_break_line(Window window, const Cell *text, int length, bool newline, int width)
+{
+    if (LB_TRUNCATE_i == window->content_lb_mode)
+    {
+        window_add_line(window, text, length);
+        return;
+    }
+    if (0 >= width)
+        return;
+
+    if (LB_SMART_i == window->content_lb_mode)
+    {
+        bool added = false;
+        while (length > width)
+        {
+            // the characters before a space at index <= width fit
+            int cut = width;
+            while ((0 < cut) && (' ' != text[cut].codepoint))
+                cut--;
+            if (0 == cut)
             {
-                if (*p == '\n')
-                {
-                    (*current_row)[i] = window->fill_line;
-                    write = false;
-                    p++;
-                }
-                else if (*p == '\0')
-                {
-                    (*current_row)[i] = window->fill_line;
-                    content_end = true;
-                }
-                else
-                    (*current_row)[i] = *p++;
+                window_add_line(window, text, width);
+                text += width;
+                length -= width;
             }
             else
-                (*current_row)[i] = window->fill_line;
-
-            // this truncates is used for window->display_mode == truncate
-            if ((LB_TRUNCATE_i == window->content_lb_mode)
-                 && write && !content_end
-                          && (current_row >= rows + top_space)
-                          && (i == window->width - right_space))
             {
-                while ((*p != '\n') && (*p != '\0'))
-                    p++;
-                if ('\0' == *p)
-                    content_end = true;
-                else
-                    p++;
+                window_add_line(window, text, cut);
+                text += cut + 1;
+                length -= cut + 1;
             }
+            added = true;
         }
-        (*current_row)[i] = '\0';
-        
-        // this part follows gets additionally executed, if instead of
-        // window->display_mode == normal, it is
-        // window->display_mode == truncate
-        // for now it just does not get executed
-        // missing is the implementation of window->display_mode == smart
+        if ((0 < length) || !added)
+            window_add_line(window, text, length);
+        return;
     }
-    
-    return rows;
+
+    // the line filling its last display line, the '\n' starts an empty one
+    bool filled = newline && (0 < length) && (0 == length % width);
+    do
+    {
+        window_add_line(window, text, MIN(length, width));
+        text += MIN(length, width);
+        length -= MIN(length, width);
+    } while (0 < length);
+    if (filled)
+        window_add_line(window, text, 0);
+}
+
+/********************************************************************
+ * window_add_line: Appends a display line to window->lines,
+ *                  growing it if necessary.
+ ********************************************************************/
+PRIVATE void window_add_line(Window window, const Cell *text, int length)
+{
+    if (window->lines_number == window->lines_capacity)
+    {
+        int capacity = MAX(2 * window->lines_capacity, 8);
+        window->lines = mem_realloc(MEM_TUI, window->lines, window->lines_capacity * sizeof(*window->lines),
+                                    capacity * sizeof(*window->lines));
+        window->lines_capacity = capacity;
+    }
+    window->lines[window->lines_number++] = (Line_span) {text, length};
+}
+
+/********************************************************************
+ * window_reverse_lines: Reverses window->lines from index from on.
+ ********************************************************************/
+PRIVATE void window_reverse_lines(Window window, int from)
+{
+    for (int i = from, j = window->lines_number - 1; i < j; i++, j--)
+    {
+        Line_span temp = window->lines[i];
+        window->lines[i] = window->lines[j];
+        window->lines[j] = temp;
+    }
+}
+
+/********************************************************************
+ * window_layout_scrollback: Breaks the lines of a scrollback window
+ *                           which fill the rows of its content
+ *                           area, going up from the newest line not
+ *                           hidden by the offset. Lines that do not
+ *                           fit completely show their bottom part.
+ *                           Lines above the view are never touched.
+ ********************************************************************/
+PRIVATE void window_layout_scrollback(Window window, int width, int rows)
+{
+    Scrollback scrollback = window->scrollback;
+    window->lines_number = 0;
+    window->layout_width = -1;
+
+    // collected newest display line first, then turned around
+    for (int index = scrollback->number - 1 - scrollback->offset;
+         (0 <= index) && (window->lines_number < rows); index--)
+    {
+        Log_line *line = scrollback_line(scrollback, index);
+        int from = window->lines_number;
+        window_break_line(window, line->text, line->length, false, width);
+        window_reverse_lines(window, from);
+    }
+    window->lines_number = MIN(window->lines_number, MAX(rows, 0));
+    window_reverse_lines(window, 0);
+}
+
+/********************************************************************
+ * utf8_to_cells: Decodes *text into cells of style 0 until
+ *                *length bytes are used or capacity cells written,
+ *                advancing *text and *length.
+ *                Returns the number of cells.
+ ********************************************************************/
+PRIVATE int utf8_to_cells(const char **text, int *length, Cell *cells, int capacity)
+{
+    int number = 0;
+    while ((0 < *length) && (number < capacity))
+    {
+        int used = utf8_decode(*text, *length, &cells[number].codepoint);
+        cells[number++].style = 0;
+        *text += used;
+        *length -= used;
+    }
+    return number;
+}
+
+/********************************************************************
+ * utf8_decode: Decodes the character at text, which has length
+ *              bytes left, to *codepoint and returns its number of
+ *              bytes. Invalid, overlong or cut sequences and
+ *              surrogates give U+FFFD for their first byte.
+ ********************************************************************/
+PRIVATE int utf8_decode(const char *text, int length, uint32_t *codepoint)
+{
+    const unsigned char *bytes = (const unsigned char *) text;
+    int number;
+    uint32_t value;
+    if (0x80 > bytes[0])
+    {
+        *codepoint = bytes[0];
+        return 1;
+    }
+    else if (0xC0 == (bytes[0] & 0xE0))
+    {
+        number = 2;
+        value = bytes[0] & 0x1F;
+    }
+    else if (0xE0 == (bytes[0] & 0xF0))
+    {
+        number = 3;
+        value = bytes[0] & 0x0F;
+    }
+    else if (0xF0 == (bytes[0] & 0xF8))
+    {
+        number = 4;
+        value = bytes[0] & 0x07;
+    }
+    else
+        number = 0;
+
+    static const uint32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+    bool valid = (0 < number) && (number <= length);
+    for (int i = 1; valid && (i < number); i++)
+    {
+        valid = (0x80 == (bytes[i] & 0xC0));
+        value = (value << 6) | (bytes[i] & 0x3F);
+    }
+    if (!valid || (minimum[number] > value) || (0x10FFFF < value) || ((0xD800 <= value) && (0xDFFF >= value)))
+    {
+        *codepoint = 0xFFFD;
+        return 1;
+    }
+    *codepoint = value;
+    return number;
+}
+
+/********************************************************************
+ * utf8_encode: Writes codepoint as UTF-8 to bytes (room for 4) and
+ *              returns the number of bytes. Code points which can
+ *              not be encoded give U+FFFD.
+ ********************************************************************/
+PRIVATE int utf8_encode(uint32_t codepoint, char *bytes)
+{
+    if (0x80 > codepoint)
+    {
+        bytes[0] = codepoint;
+        return 1;
+    }
+    if (0x800 > codepoint)
+    {
+        bytes[0] = 0xC0 | (codepoint >> 6);
+        bytes[1] = 0x80 | (codepoint & 0x3F);
+        return 2;
+    }
+    if ((0x10FFFF < codepoint) || ((0xD800 <= codepoint) && (0xDFFF >= codepoint)))
+        codepoint = 0xFFFD;
+    if (0x10000 > codepoint)
+    {
+        bytes[0] = 0xE0 | (codepoint >> 12);
+        bytes[1] = 0x80 | ((codepoint >> 6) & 0x3F);
+        bytes[2] = 0x80 | (codepoint & 0x3F);
+        return 3;
+    }
+    bytes[0] = 0xF0 | (codepoint >> 18);
+    bytes[1] = 0x80 | ((codepoint >> 12) & 0x3F);
+    bytes[2] = 0x80 | ((codepoint >> 6) & 0x3F);
+    bytes[3] = 0x80 | (codepoint & 0x3F);
+    return 4;
 }
@@ -6,9 +6,9 @@
  * Library for a simple tui.
  *
  * offers constructor and destructor for screen-objects
- * A screen is basically a linked list with pointers to windows as
- * nodes.
- * When the screen is drawn the linked list will be traversed
+ * A screen is basically an array of pointers to windows, ordered by
+ * priority.
+ * When the screen is drawn the array will be traversed
  * drawing windows one on the other.
  * screen also has height and width.
  *
@@ -30,9 +30,11 @@
 #define TUI_LIB_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct screen *Screen;
 typedef struct window *Window;
+typedef struct renderer *Renderer;
 
 typedef enum orientation {
     LEFT = 1,
@@ -46,6 +48,47 @@ typedef enum linebreak {
     LB_SMART = 3,
 } Linebreak;
 
+/********************************************************************
+ * Cell: One character of a window or a screen, a Unicode code point
+ *       and its style. Every code point takes one column, characters
+ *       a terminal draws two columns wide are not supported.
+ *
+ *       style packs the foreground and the background color (a
+ *       color of the 256 color palette or TUI_DEFAULT) and
+ *       attributes, see TUI_STYLE(). Style 0 uses the defaults of
+ *       the terminal, content cells of style 0 take the style of
+ *       their window (see window_set_style()).
+ ********************************************************************/
+typedef struct cell {
+    uint32_t codepoint;
+    uint32_t style;
+} Cell;
+
+// colors: 0 - 7 as below, 8 - 15 their bright versions, 16 - 255
+// the color cube and the grays of the 256 color palette
+#define TUI_DEFAULT (-1)
+#define TUI_BLACK 0
+#define TUI_RED 1
+#define TUI_GREEN 2
+#define TUI_YELLOW 3
+#define TUI_BLUE 4
+#define TUI_MAGENTA 5
+#define TUI_CYAN 6
+#define TUI_WHITE 7
+#define TUI_BRIGHT 8
+
+// attributes, can be combined with |
+#define TUI_BOLD (1u << 18)
+#define TUI_DIM (1u << 19)
+#define TUI_ITALIC (1u << 20)
+#define TUI_UNDERLINE (1u << 21)
+#define TUI_BLINK (1u << 22)
+#define TUI_REVERSE (1u << 23)
+
+// colors are kept + 1 in 9 bits each, so TUI_DEFAULT is 0
+#define TUI_STYLE(fg, bg, attributes) \
+    ((uint32_t) ((fg) + 1) | ((uint32_t) ((bg) + 1) << 9) | (uint32_t) (attributes))
+
 /********************************************************************
  * window_create: every window is assigned a unique identifier
  *                when created. This is the way in which
@@ -79,8 +122,7 @@ bool screen_add_window(Screen screen, Window window, int priority);
 
 /********************************************************************
  * screen_remove_window: Removes window from screen i.e. removes
- *                       a the first node with a pointer to window
- *                       from the linked list which is screen.
+ *                       the node with a pointer to window from
  *                       screen.
  *                       true on success
  *                       false if not found
@@ -175,6 +217,79 @@ bool window_set_linebreak(Window window, Linebreak lb_mode);
  ********************************************************************/
 bool window_update_content(Window window, char *content, int content_length);
 
+/********************************************************************
+ * window_update_cells: Same as window_update_content(), with the
+ *                      content given as cells, so every character
+ *                      can have a style of its own. Cells with code
+ *                      point '\n' end lines, code point 0 ends the
+ *                      content.
+ *                      window_update_content() decodes content as
+ *                      UTF-8 into cells of style 0, bytes which
+ *                      are no valid UTF-8 become U+FFFD.
+ ********************************************************************/
+bool window_update_cells(Window window, const Cell *cells, int length);
+
+/********************************************************************
+ * window_set_style: Sets the style of the frame, the fillers and
+ *                   the content cells of style 0 of window.
+ *                   Returns false if style is not made by
+ *                   TUI_STYLE() from valid colors.
+ *                   default = 0
+ ********************************************************************/
+bool window_set_style(Window window, uint32_t style);
+
+/********************************************************************
+ * Scrollback windows: A window can keep its content as a ring of
+ *                     the last max_lines lines instead of one
+ *                     string. Appending to it does not copy the
+ *                     lines already there, and once the ring is
+ *                     full the oldest line is dropped and its
+ *                     memory reused. Drawing the window only
+ *                     breaks the lines that are visible, the
+ *                     newest ones at the bottom.
+ ********************************************************************/
+
+/********************************************************************
+ * window_set_scrollback: Makes window a scrollback window keeping
+ *                        up to max_lines lines. Its content so far
+ *                        becomes its first lines. If it already is
+ *                        one, the newest lines are kept.
+ *                        Returns false if max_lines is not positive.
+ ********************************************************************/
+bool window_set_scrollback(Window window, int max_lines);
+
+/********************************************************************
+ * window_append: Appends length characters of text to a scrollback
+ *                window. Every '\n' ends a line, text after the
+ *                last one continues with the next call. text is
+ *                decoded as UTF-8, characters must not be split
+ *                between calls.
+ *                window_update_content() and window_update_cells()
+ *                replace all lines.
+ *                Returns false if window is no scrollback window or
+ *                length is negative.
+ ********************************************************************/
+bool window_append(Window window, const char *text, int length);
+
+/********************************************************************
+ * window_scroll: Shows a scrollback window with its newest lines
+ *                hidden below the view, up to all but the oldest.
+ *                0 shows the newest line at the bottom.
+ *                Returns false if window is no scrollback window or
+ *                lines is negative.
+ ********************************************************************/
+bool window_scroll(Window window, int lines);
+
+/********************************************************************
+ * window_follow_tail: With follow (the default) appending to a
+ *                     scrollback window scrolls to its newest line,
+ *                     without it the view stays on the same lines.
+ *                     Turning follow on scrolls to the newest line.
+ *                     Returns false if window is no scrollback
+ *                     window.
+ ********************************************************************/
+bool window_follow_tail(Window window, bool follow);
+
 /********************************************************************
  * window_set_fill: Sets a windows filler characters.
  *                  fill_border = used to fill the space between the
@@ -213,9 +328,77 @@ Window window_duplicate(Window window);
  *               top.
  *               This happens by creating and repeatedly modifying
  *               a string, which will be printed in the end.
+ *               The screen is drawn at the upper left corner of
+ *               the terminal. Only the characters which changed
+ *               since the last call are written (see
+ *               screen_render()).
  ********************************************************************/
 void screen_print(Screen screen);
 
+/********************************************************************
+ * screen_render: Returns the bytes screen_print() would write and
+ *                writes their number to *length. The first call,
+ *                and the first after a change of size, draws the
+ *                whole screen, later calls only the runs of changed
+ *                characters, using ANSI sequences to move the
+ *                cursor. The returned buffer belongs to screen and
+ *                is valid until the next call.
+ ********************************************************************/
+const char *screen_render(Screen screen, int *length);
+
+/********************************************************************
+ * screen_invalidate: Makes the next screen_print() draw the whole
+ *                    screen, e.g. after other output overwrote
+ *                    the terminal.
+ ********************************************************************/
+void screen_invalidate(Screen screen);
+
+/********************************************************************
+ * Renderer: An optional thread owning the output to a terminal.
+ *           renderer_publish() composites a screen on the calling
+ *           thread and hands the finished frame over to the
+ *           thread, which diffs it against the last frame it wrote
+ *           and writes the changes. There are two frame buffers:
+ *           the one being written and one pending. If the
+ *           terminal falls behind, newer frames replace the
+ *           pending one, so intermediate frames are skipped, but
+ *           the last one published is always written.
+ *           Nothing else should write to fd while the renderer
+ *           exists (or call renderer_flush() before).
+ ********************************************************************/
+
+/********************************************************************
+ * renderer_create: Starts a render thread writing to fd.
+ *                  Returns NULL if the thread can not be started.
+ ********************************************************************/
+Renderer renderer_create(int fd);
+
+/********************************************************************
+ * renderer_destroy: Writes the pending frame, stops the thread and
+ *                   frees renderer. Does not close fd.
+ ********************************************************************/
+void renderer_destroy(Renderer renderer);
+
+/********************************************************************
+ * renderer_publish: Makes the current state of screen the next
+ *                   frame of renderer. Returns without waiting for
+ *                   the output. screen can be changed right after.
+ ********************************************************************/
+void renderer_publish(Renderer renderer, Screen screen);
+
+/********************************************************************
+ * renderer_flush: Waits until every published frame is either
+ *                 written or was replaced by a newer one.
+ ********************************************************************/
+void renderer_flush(Renderer renderer);
+
+/********************************************************************
+ * renderer_statistics: Writes the number of frames published and
+ *                      the number of frames written, the
+ *                      difference was coalesced.
+ ********************************************************************/
+void renderer_statistics(Renderer renderer, long *published, long *written);
+
 /********************************************************************
  * window_print_content: returns the id of the window.
  ********************************************************************/
@@ -19,6 +19,24 @@
 #include <string.h>
 
 // necessary declarations from tui_lib.c
+typedef struct rect {
+    int row;
+    int column;
+    int height;
+    int width;
+} Rect;
+
+typedef struct emitted_frame {
+    Cell *frame;
+    int height;
+    int width;
+    char *output;
+    int output_length;
+    int output_capacity;
+    uint32_t style;
+    unsigned long diffed;
+} Emitted_frame;
+
 typedef struct node_ptr_to_screen {
     Screen screen;
     struct node_ptr_to_screen *next;
@@ -41,6 +59,7 @@ struct window {
     // filler variables
     char fill_line;
     char fill_border;
+    uint32_t style;
     // space at boarder (all >= 0)
     int space_top;
     int space_bot;
@@ -50,20 +69,27 @@ struct window {
     int content_orientation;
     int content_lb_mode;
     int content_length;
-    char *content;
-    // display_strings;
-    char **display_strings;
+    int content_capacity;
+    Cell *content;
+    void *lines;
+    int lines_number;
+    int lines_capacity;
+    int layout_width;
+    int layout_longest;
+    void *scrollback;
+    // height * width cells, row after row
+    Cell *display;
+    int display_capacity;
     bool changed;
-    int old_height;
     Window_screen_list screens;
 };
 
 typedef struct node_ptr_to_window {
-    int priority;
+    long long priority;
     int pos_hori;
     int pos_vert;
     Window window;
-    struct node_ptr_to_window *next;
+    Rect drawn;
 } Node_ptr_to_window;
 
 struct screen {
@@ -72,9 +98,19 @@ struct screen {
     int width;
     char background;
     bool changed;
-    int old_height;
-    char **display_strings;
-    Node_ptr_to_window *lowest;
+    // height * width cells, row after row
+    Cell *display;
+    int display_capacity;
+    Rect dirty[16];
+    int dirty_number;
+    unsigned long frame_number;
+    Node_ptr_to_window **nodes;
+    int nodes_number;
+    int nodes_capacity;
+    long long priority_bias;
+    Node_ptr_to_window **by_id;
+    int by_id_capacity;
+    Emitted_frame emitted;
 };
 
 PRIVATE int compare_ints(const void *a, const void *b);
@@ -114,12 +150,8 @@ Window create_test_window(int height, int width)
 void screen_print_info(Screen screen)
 {
     printf("windows in screen %d:\n", screen->id);
-    Node_ptr_to_window *p = screen->lowest;
-    while (NULL != p)
-    {
-        printf("id = %3d prio = %3d\n", p->window->id, p->priority);
-        p = p->next;
-    }
+    for (int i = 0; i < screen->nodes_number; i++)
+        printf("id = %3d prio = %3lld\n", screen->nodes[i]->window->id, screen->nodes[i]->priority + screen->priority_bias);
 }
 
 /********************************************************************
@@ -142,7 +174,20 @@ void window_print_info(Window window)
  ********************************************************************/
 void window_print_content(Window window)
 {
-    puts(window->content);
+    // UTF-8 of the cells, styles are left out
+    for (int i = 0; i < window->content_length; i++)
+    {
+        uint32_t c = window->content[i].codepoint;
+        if (0x80 > c)
+            putchar(c);
+        else if (0x800 > c)
+            printf("%c%c", 0xC0 | (c >> 6), 0x80 | (c & 0x3F));
+        else if (0x10000 > c)
+            printf("%c%c%c", 0xE0 | (c >> 12), 0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+        else
+            printf("%c%c%c%c", 0xF0 | (c >> 18), 0x80 | ((c >> 12) & 0x3F), 0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+    }
+    putchar('\n');
 }
 
 /********************************************************************
@@ -169,24 +214,13 @@ int window_id(Window window)
  ********************************************************************/
 int *screen_windows_id(Screen screen, int *amount)
 {
-    *amount = 0;
-    Node_ptr_to_window *p = screen->lowest;
-    while (NULL != p)
-    {
-        (*amount)++;
-        p = p->next;
-    }
+    *amount = screen->nodes_number;
 
     int *ids = malloc(*amount * sizeof(*ids));
     MEM_TEST(ids);
 
-    int *q = ids;
-    p = screen->lowest;
-    while (NULL != p)
-    {
-        *q++ = p->window->id;
-        p = p->next;
-    }
+    for (int i = 0; i < *amount; i++)
+        ids[i] = screen->nodes[i]->window->id;
 
     return ids;
 }
@@ -199,25 +233,13 @@ int *screen_windows_id(Screen screen, int *amount)
  ********************************************************************/
 int *screen_windows_prio(Screen screen, int *amount)
 {
-    *amount = 0;
-    Node_ptr_to_window *p = screen->lowest;
-    while (NULL != p)
-    {
-        (*amount)++;
-        p = p->next;
-    }
+    *amount = screen->nodes_number;
 
     int *priorities = malloc(*amount * sizeof(*priorities));
     MEM_TEST(priorities);
 
-    int *q = priorities;
-    p = screen->lowest;
-    while (NULL != p)
-    {
-        *q = p->priority;
-        p = p->next;
-        q++;
-    }
+    for (int i = 0; i < *amount; i++)
+        priorities[i] = screen->nodes[i]->priority + screen->priority_bias;
 
     return priorities;
 }
@@ -0,0 +1,81 @@
+// Copyright: (c) 2023, Alrik Neumann
+// GNU General Public License v3.0+ (see LICENSE.txt or https://www.gnu.org/licenses/gpl-3.0.txt)
+
+/********************************************************************
+ * zobrist.h                                                        *
+ *                                                                  *
+ * Zobrist hashing of Game_states. Every feature of a position      *
+ * (a piece on a square, a castling right, an en passant file and   *
+ * the player to move) is assigned a random 64-bit number. The key  *
+ * of a position is the xor of the numbers of all its features.     *
+ *                                                                  *
+ * The numbers are laid out like the Random64 table of the          *
+ * Polyglot book format:                                            *
+ *    0 - 767   pieces (64 * piece + 8 * row + column)              *
+ *  768 - 771   castling rights                                     *
+ *  772 - 779   en passant file                                     *
+ *  780         white to move                                       *
+ * The default table is the Polyglot table itself, so keys match    *
+ * Polyglot books made by other programs.                           *
+ ********************************************************************/
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "core_functions.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ZOBRIST_TABLE_SIZE 781
+#define ZOBRIST_CASTLE_OFFSET 768
+#define ZOBRIST_EN_PASSANT_OFFSET 772
+#define ZOBRIST_TURN_OFFSET 780
+
+/********************************************************************
+ * zobrist_load_table: Reads ZOBRIST_TABLE_SIZE 64-bit big-endian   *
+ *                     numbers from the file at path and uses them  *
+ *                     instead of the Polyglot table.               *
+ *                     Returns false if the file can not be read or *
+ *                     is too short. The table stays unchanged in   *
+ *                     that case.                                   *
+ ********************************************************************/
+bool zobrist_load_table(const char *path);
+
+/********************************************************************
+ * zobrist_number: Returns entry index of the table.                *
+ ********************************************************************/
+uint64_t zobrist_number(int index);
+
+/********************************************************************
+ * zobrist_piece_index: Returns the table index for piece on        *
+ *                      (row, column).                              *
+ ********************************************************************/
+int zobrist_piece_index(Piece_i piece, int row, int column);
+
+/********************************************************************
+ * zobrist_piece: Returns the number of piece on (row, column), 0   *
+ *                for EMPTY. Xoring it into a key adds or removes   *
+ *                the piece.                                        *
+ ********************************************************************/
+uint64_t zobrist_piece(Piece_i piece, int row, int column);
+
+/********************************************************************
+ * zobrist_extras: Returns the part of the key of state not         *
+ *                 depending on the pieces alone: castling rights,  *
+ *                 en passant and the player to move.               *
+ ********************************************************************/
+uint64_t zobrist_extras(const Game_state *state);
+
+/********************************************************************
+ * zobrist_key: Computes the key of state from scratch.             *
+ *              apply_move() keeps state->key up to date            *
+ *              incrementally, this is for new states.              *
+ ********************************************************************/
+uint64_t zobrist_key(const Game_state *state);
+
+/********************************************************************
+ * zobrist_pawn_key: Computes the key of the pawns of state only    *
+ *                   from scratch (see state->pawn_key).            *
+ ********************************************************************/
+uint64_t zobrist_pawn_key(const Game_state *state);
+
+#endif